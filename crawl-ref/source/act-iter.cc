@@ -2,12 +2,67 @@
 
 #include "act-iter.h"
 
+#include "coordit.h"
 #include "env.h"
 #include "losglobal.h"
 
+// Whether near iterators only look at the monsters the monster grid has
+// within range, or at every monster slot. Only changed for benchmarking.
+static bool near_iterator_index = true;
+
+void set_near_iterator_index(bool indexed)
+{
+    near_iterator_index = indexed;
+}
+
+// Nothing beyond LOS_MAX_RANGE can be in sight, so rather than checking
+// every monster slot, start from those the monster grid has standing close
+// enough. Monsters are still checked, in index order, as they're reached;
+// ones that step into range after the iterator was made are missed.
+void monster_index_set::fill_near(const coord_def &c, los_type los)
+{
+    if (los == LOS_NONE || !near_iterator_index)
+    {
+        memset(bits, 0xff, sizeof(bits));
+        return;
+    }
+
+    memset(bits, 0, sizeof(bits));
+    const coord_def tl(max(c.x - LOS_MAX_RANGE, 0), max(c.y - LOS_MAX_RANGE, 0));
+    const coord_def br(min(c.x + LOS_MAX_RANGE, GXM - 1),
+                       min(c.y + LOS_MAX_RANGE, GYM - 1));
+    if (tl.x > br.x || tl.y > br.y)
+        return;
+
+    for (rectangle_iterator ri(tl, br); ri; ++ri)
+    {
+        const int mid = env.mgrid(*ri);
+        if (mid != NON_MONSTER)
+            bits[mid / 64] |= uint64_t(1) << (mid % 64);
+    }
+}
+
+int monster_index_set::next(int i) const
+{
+    for (++i; i < MAX_MONSTERS; ++i)
+    {
+        const uint64_t word = bits[i / 64] >> (i % 64);
+        if (!word)
+        {
+            // Skip to the start of the next word.
+            i |= 63;
+            continue;
+        }
+        if (word & 1)
+            return i;
+    }
+    return MAX_MONSTERS;
+}
+
 actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
     : center(c), _los(los), viewer(nullptr), i(-1)
 {
+    nearby.fill_near(center, _los);
     if (!valid(&you))
         advance();
 }
@@ -15,6 +70,7 @@ actor_near_iterator::actor_near_iterator(coord_def c, los_type los)
 actor_near_iterator::actor_near_iterator(const actor* a, los_type los)
     : center(a->pos()), _los(los), viewer(a), i(-1)
 {
+    nearby.fill_near(center, _los);
     if (!valid(&you))
         advance();
 }
@@ -64,7 +120,7 @@ bool actor_near_iterator::valid(const actor* a) const
 void actor_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = nearby.next(i)) >= MAX_MONSTERS)
              return;
     while (!valid(**this));
 }
@@ -72,18 +128,18 @@ void actor_near_iterator::advance()
 //////////////////////////////////////////////////////////////////////////
 
 monster_near_iterator::monster_near_iterator(coord_def c, los_type los)
-    : center(c), _los(los), viewer(nullptr), i(0)
+    : center(c), _los(los), viewer(nullptr), i(-1)
 {
-    if (!valid(&env.mons[0]))
-        advance();
+    nearby.fill_near(center, _los);
+    advance();
     begin_point = i;
 }
 
 monster_near_iterator::monster_near_iterator(const actor *a, los_type los)
-    : center(a->pos()), _los(los), viewer(a), i(0)
+    : center(a->pos()), _los(los), viewer(a), i(-1)
 {
-    if (!valid(&env.mons[0]))
-        advance();
+    nearby.fill_near(center, _los);
+    advance();
     begin_point = i;
 }
 
@@ -154,7 +210,7 @@ bool monster_near_iterator::valid(const monster* a) const
 void monster_near_iterator::advance()
 {
     do
-         if (++i >= MAX_MONSTERS)
+         if ((i = nearby.next(i)) >= MAX_MONSTERS)
              return;
     while (!valid(**this));
 }
@@ -162,10 +218,9 @@ void monster_near_iterator::advance()
 //////////////////////////////////////////////////////////////////////////
 
 monster_iterator::monster_iterator()
-    : i(0)
+    : i(-1), pos(0)
 {
-    while (i < MAX_MONSTERS && !env.mons[i].alive())
-        i++;
+    advance();
 }
 
 monster_iterator::operator bool() const
@@ -188,9 +243,7 @@ monster* monster_iterator::operator->() const
 
 monster_iterator& monster_iterator::operator++()
 {
-    while (++i < MAX_MONSTERS)
-        if (env.mons[i].alive())
-            break;
+    advance();
     return *this;
 }
 
@@ -201,10 +254,26 @@ monster_iterator monster_iterator::operator++(int)
     return copy;
 }
 
+// Visits the live monsters in index order, just as a scan of env.mons
+// would, even when monsters are placed or reset during the iteration.
 void monster_iterator::advance()
 {
-    do
-         if (++i >= MAX_MONSTERS)
-             return;
-    while (!(*this)->alive());
+    const vector<unsigned short> &used = env.mons_used;
+
+    // The list may have changed since the last step; if so, find our place
+    // again.
+    if (pos < used.size() && used[pos] == i)
+        ++pos;
+    else
+        pos = upper_bound(used.begin(), used.end(), i) - used.begin();
+
+    for (; pos < used.size(); ++pos)
+    {
+        if (env.mons[used[pos]].alive())
+        {
+            i = used[pos];
+            return;
+        }
+    }
+    i = MAX_MONSTERS;
 }
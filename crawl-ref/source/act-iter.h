@@ -5,8 +5,24 @@
 
 #pragma once
 
+#include "defines.h"
 #include "los-type.h"
 
+void set_near_iterator_index(bool indexed);
+
+// The monsters standing within LOS range of a point, by index, taken from
+// the monster grid when a near iterator is made.
+class monster_index_set
+{
+public:
+    void fill_near(const coord_def &c, los_type los);
+    // The next index after i, or MAX_MONSTERS if there are no more.
+    int next(int i) const;
+
+private:
+    uint64_t bits[(MAX_MONSTERS + 63) / 64];
+};
+
 class actor_near_iterator
 {
 public:
@@ -24,6 +40,7 @@ protected:
     los_type _los;
     const actor* viewer;
     int i;
+    monster_index_set nearby;
 
     bool valid(const actor* a) const;
     void advance();
@@ -51,6 +68,7 @@ protected:
     const actor* viewer;
     int i;
     int begin_point;
+    monster_index_set nearby;
 
     bool valid(const monster* a) const;
     void advance();
@@ -69,5 +87,6 @@ public:
 
 protected:
     int i;
+    size_t pos; // hint: where i was in env.mons_used
     void advance();
 };
@@ -38,6 +38,7 @@ public:
 
     monster_type type;
     mid_t        mid;
+    coord_def    position;
     virtual int       mindex() const = 0;
 
     virtual bool is_player() const = 0;
@@ -398,8 +399,6 @@ public:
     virtual level_id shaft_dest() const;
     virtual bool     do_shaft() = 0;
 
-    coord_def position;
-
     CrawlHashTable props;
 
     int shield_blocks;                 // Count of shield blocks this round.
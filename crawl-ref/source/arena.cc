@@ -7,6 +7,7 @@
 
 #include "arena.h"
 
+#include <chrono>
 #include <stdexcept>
 
 #include "act-iter.h"
@@ -234,6 +235,11 @@ namespace arena
 
     static bool miscasts            = false;
 
+    // Time spent in world_reacts, for the time_turns tag.
+    static bool time_turns          = false;
+    static int  timed_turns         = 0;
+    static chrono::duration<double> react_time;
+
     static int  summon_throttle     = INT_MAX;
 
     static vector<monster_type> uniques_list;
@@ -444,6 +450,7 @@ namespace arena
         miscasts        =  strip_tag(spec, "miscasts");
         respawn         =  strip_tag(spec, "respawn");
         move_respawns   =  strip_tag(spec, "move_respawns");
+        time_turns      =  strip_tag(spec, "time_turns");
         summon_throttle = strip_number_tag(spec, "summon_throttle:");
 
         if (real_summons && respawn)
@@ -878,7 +885,10 @@ namespace arena
 
                 you.time_taken = 10;
                 //report_foes();
+                const auto start = chrono::steady_clock::now();
                 world_reacts();
+                react_time += chrono::steady_clock::now() - start;
+                timed_turns++;
                 do_miscasts();
                 do_respawn(faction_a);
                 do_respawn(faction_b);
@@ -977,6 +987,8 @@ namespace arena
         // Clear some things that shouldn't persist across restart_after_game.
         // parse_monster_spec and setup_fight will clear the rest.
         total_trials = trials_done = team_a_wins = ties = 0;
+        timed_turns = 0;
+        react_time = chrono::duration<double>::zero();
         contest_cancelled = false;
         is_respawning = false;
         uniques_list.clear();
@@ -1025,6 +1037,11 @@ namespace arena
             if (ties > 0)
                 fprintf(file, "-%d", ties);
             fprintf(file, "\n");
+            if (time_turns && timed_turns > 0)
+            {
+                fprintf(file, "world_reacts: %d turns, %.1f us/turn\n",
+                        timed_turns, react_time.count() * 1e6 / timed_turns);
+            }
         }
     }
 
@@ -1074,23 +1074,50 @@ void bolt::affect_cell()
         affect_ground();
 }
 
-static void _undo_tracer(bolt &orig, bolt &copy)
-{
-    // FIXME: we should have a better idea of what gets changed!
-    orig.target           = copy.target;
-    orig.source           = copy.source;
-    orig.aimed_at_spot    = copy.aimed_at_spot;
-    orig.extra_range_used = copy.extra_range_used;
-    orig.auto_hit         = copy.auto_hit;
-    orig.ray              = copy.ray;
-    orig.colour           = copy.colour;
-    orig.flavour          = copy.flavour;
-    orig.real_flavour     = copy.real_flavour;
-    orig.bounces          = copy.bounces;
-    orig.bounce_pos       = copy.bounce_pos;
-}
-
-// This saves some important things before calling fire().
+// The fields firing a tracer changes and fire() puts back afterwards. Only
+// these are kept, rather than a copy of the whole bolt, so that tracing
+// doesn't copy strings or allocate.
+struct tracer_saved_state
+{
+    coord_def target;
+    coord_def source;
+    bool aimed_at_spot;
+    int extra_range_used;
+    bool auto_hit;
+    ray_def ray;
+    colour_t colour;
+    beam_type flavour;
+    beam_type real_flavour;
+    int bounces;
+    coord_def bounce_pos;
+
+    explicit tracer_saved_state(const bolt &beam)
+        : target(beam.target), source(beam.source),
+          aimed_at_spot(beam.aimed_at_spot),
+          extra_range_used(beam.extra_range_used), auto_hit(beam.auto_hit),
+          ray(beam.ray), colour(beam.colour), flavour(beam.flavour),
+          real_flavour(beam.real_flavour), bounces(beam.bounces),
+          bounce_pos(beam.bounce_pos)
+    {
+    }
+
+    void restore(bolt &beam) const
+    {
+        // FIXME: we should have a better idea of what gets changed!
+        beam.target           = target;
+        beam.source           = source;
+        beam.aimed_at_spot    = aimed_at_spot;
+        beam.extra_range_used = extra_range_used;
+        beam.auto_hit         = auto_hit;
+        beam.ray              = ray;
+        beam.colour           = colour;
+        beam.flavour          = flavour;
+        beam.real_flavour     = real_flavour;
+        beam.bounces          = bounces;
+        beam.bounce_pos       = bounce_pos;
+    }
+};
+
 void bolt::fire()
 {
     path_taken.clear();
@@ -1100,19 +1127,17 @@ void bolt::fire()
 
     if (is_tracer)
     {
-        bolt boltcopy = *this;
-        if (special_explosion != nullptr)
-            boltcopy.special_explosion = new bolt(*special_explosion);
-
-        do_fire();
-
+        const tracer_saved_state saved(*this);
         if (special_explosion != nullptr)
         {
-            _undo_tracer(*special_explosion, *boltcopy.special_explosion);
-            delete boltcopy.special_explosion;
+            const tracer_saved_state saved_explosion(*special_explosion);
+            do_fire();
+            saved_explosion.restore(*special_explosion);
         }
+        else
+            do_fire();
 
-        _undo_tracer(*this, boltcopy);
+        saved.restore(*this);
     }
     else
         do_fire();
@@ -7,6 +7,12 @@
 
 #include "bitary.h"
 
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
 bit_vector::bit_vector(unsigned long s)
     : size(s)
 {
@@ -61,6 +67,59 @@ bit_vector& bit_vector::operator |= (const bit_vector& other)
     return *this;
 }
 
+// OR all of others into this vector. The vectorised kernel walks the
+// words once, keeping each block in a register while it ORs in every
+// source; otherwise each source is ORed in separately.
+bit_vector& bit_vector::unite(const bit_vector* const others[], int count,
+                              bool vectorised)
+{
+    if (!vectorised)
+    {
+        for (int i = 0; i < count; ++i)
+            *this |= *others[i];
+        return *this;
+    }
+
+    for (int i = 0; i < count; ++i)
+        ASSERT(size == others[i]->size);
+
+    int w = 0;
+#if defined(__AVX2__)
+    const int wide = sizeof(__m256i) / sizeof(unsigned long);
+    for (; w + wide <= nwords; w += wide)
+    {
+        __m256i acc = _mm256_loadu_si256((const __m256i*)(data + w));
+        for (int i = 0; i < count; ++i)
+        {
+            acc = _mm256_or_si256(acc,
+                      _mm256_loadu_si256((const __m256i*)(others[i]->data + w)));
+        }
+        _mm256_storeu_si256((__m256i*)(data + w), acc);
+    }
+#elif defined(__SSE2__)
+    const int wide = sizeof(__m128i) / sizeof(unsigned long);
+    for (; w + wide <= nwords; w += wide)
+    {
+        __m128i acc = _mm_loadu_si128((const __m128i*)(data + w));
+        for (int i = 0; i < count; ++i)
+        {
+            acc = _mm_or_si128(acc,
+                      _mm_loadu_si128((const __m128i*)(others[i]->data + w)));
+        }
+        _mm_storeu_si128((__m128i*)(data + w), acc);
+    }
+#endif
+    // Whatever is left over, or everything without SSE2.
+    for (; w < nwords; ++w)
+    {
+        unsigned long acc = data[w];
+        for (int i = 0; i < count; ++i)
+            acc |= others[i]->data[w];
+        data[w] = acc;
+    }
+    return *this;
+}
+
 bit_vector& bit_vector::operator &= (const bit_vector& other)
 {
     ASSERT(size == other.size);
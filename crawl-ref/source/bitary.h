@@ -30,6 +30,8 @@ public:
     void set(unsigned long index, bool value = true);
 
     bit_vector& operator |= (const bit_vector& other);
+    bit_vector& unite(const bit_vector* const others[], int count,
+                      bool vectorised = true);
     bit_vector& operator &= (const bit_vector& other);
     bit_vector  operator & (const bit_vector& other) const;
 
@@ -0,0 +1,34 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "bitary.h"
+
+TEST_CASE("bit_vector::unite", "[single-file]")
+{
+    SECTION("Vectorised union matches repeated |=")
+    {
+        const auto size = GENERATE(1, 63, 64, 65, 255, 700, 1031);
+        const auto count = GENERATE(0, 1, 2, 7);
+
+        CAPTURE(size, count);
+
+        vector<bit_vector> sources(count, bit_vector(size));
+        for (int i = 0; i < count; ++i)
+            for (int b = i; b < size; b += 3 + i)
+                sources[i].set(b);
+
+        vector<const bit_vector*> ptrs;
+        for (const bit_vector &v : sources)
+            ptrs.push_back(&v);
+
+        bit_vector wide(size), narrow(size);
+        wide.set(size - 1);
+        narrow.set(size - 1);
+        wide.unite(ptrs.data(), count);
+        narrow.unite(ptrs.data(), count, false);
+
+        for (int b = 0; b < size; ++b)
+            REQUIRE(wide.get(b) == narrow.get(b));
+    }
+}
@@ -0,0 +1,68 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "item-def.h"
+#include "map-cell.h"
+
+TEST_CASE("Map cell copies share their payloads", "[single-file]")
+{
+    item_def dagger;
+    dagger.base_type = OBJ_WEAPONS;
+    dagger.quantity = 1;
+
+    map_cell cell;
+    cell.set_item(dagger, false);
+
+    SECTION("Copies point at the same item")
+    {
+        const map_cell copy(cell);
+        REQUIRE(copy.item() == cell.item());
+        REQUIRE(copy == cell);
+    }
+
+    SECTION("Changing a copy leaves the original alone")
+    {
+        map_cell copy(cell);
+        copy.mutable_item()->quantity = 5;
+
+        REQUIRE(copy.item() != cell.item());
+        REQUIRE(copy.item()->quantity == 5);
+        REQUIRE(cell.item()->quantity == 1);
+    }
+
+    SECTION("Replacing the item of a copy leaves the original alone")
+    {
+        map_cell copy;
+        copy = cell;
+
+        item_def arrows;
+        arrows.base_type = OBJ_MISSILES;
+        arrows.quantity = 10;
+        copy.set_item(arrows, true);
+
+        REQUIRE(copy.item()->base_type == OBJ_MISSILES);
+        REQUIRE(cell.item()->base_type == OBJ_WEAPONS);
+        REQUIRE(cell.item()->quantity == 1);
+        REQUIRE(!(cell.flags & MAP_MORE_ITEMS));
+    }
+
+    SECTION("An unshared item is updated in place")
+    {
+        const item_def *before = cell.item();
+        dagger.quantity = 3;
+        cell.set_item(dagger, false);
+
+        REQUIRE(cell.item() == before);
+        REQUIRE(cell.item()->quantity == 3);
+    }
+
+    SECTION("Clearing a copy leaves the original alone")
+    {
+        map_cell copy(cell);
+        copy.clear_item();
+
+        REQUIRE(!copy.item());
+        REQUIRE(cell.item()->base_type == OBJ_WEAPONS);
+    }
+}
@@ -0,0 +1,62 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "package.h"
+
+#ifdef USE_ZSTD
+
+// Bytes that compress somewhat, but not to nothing.
+static vector<unsigned char> _chunk_data(size_t len, uint32_t seed)
+{
+    vector<unsigned char> data(len);
+    for (size_t i = 0; i < len; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        data[i] = (seed >> 16) & 0x1f;
+    }
+    return data;
+}
+
+static void _write_chunk(package &pkg, const string &name,
+                         const vector<unsigned char> &data)
+{
+    chunk_writer *w = pkg.writer(name);
+    w->write(data.data(), data.size());
+    delete w;
+}
+
+TEST_CASE("zstd chunks read back a byte at a time", "[single-file]")
+{
+    const bool mmap = GENERATE(false, true);
+
+    package pkg;
+    pkg.set_codec(chunk_codec::zstd);
+    pkg.set_mmap(mmap);
+
+    // Leave a hole near the start of the file, so that the big chunk is
+    // split over more than one block.
+    _write_chunk(pkg, "hole", _chunk_data(2000, 1));
+    _write_chunk(pkg, "keep", _chunk_data(100, 2));
+    pkg.commit();
+    pkg.delete_chunk("hole");
+    pkg.commit();
+
+    // Several zstd blocks' worth.
+    const vector<unsigned char> data = _chunk_data(400000, 3);
+    _write_chunk(pkg, "big", data);
+    pkg.commit();
+    REQUIRE(pkg.get_chunk_fragmentation("big") > 1);
+
+    chunk_reader *r = pkg.reader("big");
+    REQUIRE(r);
+    vector<unsigned char> read;
+    unsigned char c;
+    while (r->read(&c, 1))
+        read.push_back(c);
+    delete r;
+
+    REQUIRE(read == data);
+}
+
+#endif
@@ -212,6 +212,40 @@ TEST_CASE( "Basic marshalling/unmarshalling works correctly.", "[single-file]" )
         }
     }
 
+    SECTION ("Spans match marshalling one value at a time.") {
+        rng::subgenerator subgen(0, 0);
+
+        // Longer than the staging buffer, so that it gets reused.
+        vector<int16_t> shorts(5000);
+        vector<int32_t> ints(5000);
+        for (auto i = 0; i < 5000; i++)
+        {
+            shorts[i] = random_range(INT16_MIN, INT16_MAX);
+            ints[i] = (int32_t)((uint32_t)random_range(0, 0xffff) << 16
+                                | random_range(0, 0xffff));
+        }
+
+        vector<unsigned char> one, bulk;
+        auto w1 = writer(&one);
+        auto w2 = writer(&bulk);
+        for (auto i = 0; i < 5000; i++)
+            marshallShort(w1, shorts[i]);
+        for (auto i = 0; i < 5000; i++)
+            marshallInt(w1, ints[i]);
+        marshallShorts(w2, shorts.data(), shorts.size());
+        marshallInts(w2, ints.data(), ints.size());
+        REQUIRE(one == bulk);
+
+        auto r = reader(bulk);
+        vector<int16_t> roundtrip_shorts(5000);
+        vector<int32_t> roundtrip_ints(5000);
+        unmarshallShorts(r, roundtrip_shorts.data(), roundtrip_shorts.size());
+        unmarshallInts(r, roundtrip_ints.data(), roundtrip_ints.size());
+        REQUIRE(shorts == roundtrip_shorts);
+        REQUIRE(ints == roundtrip_ints);
+        REQUIRE(r.valid() == false);
+    }
+
     SECTION ("Map cells can be roundtripped.") {
         auto roundtrip_map_cell = [](const map_cell cell) {
             vector<unsigned char> buf;
@@ -113,7 +113,7 @@ colour_t make_high_colour(colour_t colour)
 }
 
 // returns if a colour is one of the special element colours (ie not regular)
-static bool _is_element_colour(int col)
+bool is_element_colour(int col)
 {
     // stripping any COLFLAGS (just in case)
     col = col & 0x007f;
@@ -637,7 +637,7 @@ void init_element_colours()
 int element_colour(int element, bool no_random, const coord_def& loc)
 {
     // pass regular colours through for safety.
-    if (!_is_element_colour(element))
+    if (!is_element_colour(element))
         return element;
 
     // Strip COLFLAGs just in case.
@@ -646,7 +646,7 @@ int element_colour(int element, bool no_random, const coord_def& loc)
     ASSERT(element_colours[element]);
     int ret = element_colours[element]->get(loc, no_random);
 
-    ASSERT(!_is_element_colour(ret));
+    ASSERT(!is_element_colour(ret));
 
     return (ret == BLACK) ? GREEN : ret;
 }
@@ -782,7 +782,7 @@ unsigned real_colour(unsigned raw_colour, const coord_def& loc)
     const int colflags = raw_colour & 0xFF00;
 
     // Evaluate any elemental colours to guarantee vanilla colour is returned
-    if (_is_element_colour(raw_colour))
+    if (is_element_colour(raw_colour))
         raw_colour = colflags | element_colour(raw_colour, false, loc);
 
     return raw_colour;
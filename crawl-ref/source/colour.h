@@ -127,5 +127,6 @@ bool get_orb_phase(const coord_def& loc);
 int dam_colour(const monster_info&);
 colour_t rune_colour(int type);
 
+bool is_element_colour(int col);
 // Applies ETC_ colour substitutions
 unsigned real_colour(unsigned raw_colour, const coord_def& loc = coord_def());
@@ -9,6 +9,7 @@
 
 #include <cstdlib>
 #include <fcntl.h>
+#include <unordered_map>
 #include <sys/stat.h>
 #include <sys/types.h>
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
@@ -25,6 +26,41 @@
 #include "syscalls.h"
 #include "unicode.h"
 
+// A database entry as fetched from the backend. Its weighted alternatives
+// are split out the first time a random choice is made from it.
+struct db_entry
+{
+    db_entry() : found(false), split(false), error(nullptr) { }
+
+    bool found;
+    string text;
+
+    bool split;
+    vector<string> parts;
+    vector<int> weights;    // running totals
+    const char *error;
+};
+
+// The most recently used entries of a database, so that repeated lookups
+// (monster speech and shouts, mostly) skip both the backend and the
+// reparsing of weights.
+class db_cache
+{
+public:
+    db_entry *find(const string &key);
+    db_entry &insert(const string &key, db_entry &&entry);
+    void clear();
+
+private:
+    typedef list<pair<string, db_entry>> entry_list;
+
+    entry_list entries;     // most recently used first
+    unordered_map<string, entry_list::iterator> index;
+    db_entry uncached;      // for when the cache is turned off
+};
+
+static db_cache_stats cache_stats;
+
 // TextDB handles dependency checking the db vs text files, creating the
 // db, loading, and destroying the DB.
 class TextDB
@@ -38,6 +74,7 @@ public:
     void init();
     void shutdown(bool recursive = false);
     DBM* get() { return _db; }
+    db_entry &fetch(const string &key, bool untranslated = false);
 
     // Make it easier to migrate from raw DBM* to TextDB
     operator bool() const { return _db != 0; }
@@ -55,6 +92,7 @@ public:
     DBM* _db;
     string timestamp;
     TextDB *_parent;
+    db_cache cache;
     const char* lang() { return _parent ? Options.lang_name : 0; }
 public:
     TextDB *translation;
@@ -67,6 +105,7 @@ static void _store_text_db(const string &in, DBM *db);
 static string _query_database(TextDB &db, string key, bool canonicalise_key,
                               bool run_lua, bool untranslated = false);
 static void _add_entry(DBM *db, const string &k, string &v);
+static datum _database_fetch(DBM *database, const string &key);
 
 static TextDB AllDBs[] =
 {
@@ -156,6 +195,48 @@ static string _db_cache_path(string db, const char *lang)
     return savedir_versioned_path("db/" + db);
 }
 
+// ----------------------------------------------------------------------
+// db_cache
+// ----------------------------------------------------------------------
+
+db_entry *db_cache::find(const string &key)
+{
+    auto it = index.find(key);
+    if (it == index.end())
+        return nullptr;
+
+    entries.splice(entries.begin(), entries, it->second);
+    return &it->second->second;
+}
+
+db_entry &db_cache::insert(const string &key, db_entry &&entry)
+{
+    const size_t capacity = max(Options.db_cache_size, 0);
+    if (!capacity)
+    {
+        clear();
+        uncached = move(entry);
+        return uncached;
+    }
+
+    while (entries.size() >= capacity)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+        cache_stats.evictions++;
+    }
+
+    entries.emplace_front(key, move(entry));
+    index[key] = entries.begin();
+    return entries.front().second;
+}
+
+void db_cache::clear()
+{
+    entries.clear();
+    index.clear();
+}
+
 // ----------------------------------------------------------------------
 // TextDB
 // ----------------------------------------------------------------------
@@ -183,6 +264,7 @@ bool TextDB::open_db()
     _db = dbm_open(full_db_path.c_str(), O_RDONLY, 0660);
     if (!_db)
         return false;
+    cache.clear();
 
     timestamp = _query_database(*this, "TIMESTAMP", false, false, true);
     if (timestamp.empty())
@@ -214,6 +296,7 @@ void TextDB::init()
 
 void TextDB::shutdown(bool recursive)
 {
+    cache.clear();
     if (_db)
     {
         dbm_close(_db);
@@ -261,6 +344,9 @@ bool TextDB::_needs_update() const
 void TextDB::_regenerate_db()
 {
     shutdown();
+    // The parent caches whatever its translation returned.
+    if (_parent)
+        _parent->cache.clear();
     if (_parent)
     {
 #ifdef DEBUG_DIAGNOSTICS
@@ -318,6 +404,33 @@ void TextDB::_regenerate_db()
     _db = 0;
 }
 
+// Look up a key, in the translation first if there is one.
+db_entry &TextDB::fetch(const string &key, bool untranslated)
+{
+    // Keys are single lines, so this can't collide with a real one.
+    const string cache_key = untranslated ? "\n" + key : key;
+    if (db_entry *entry = cache.find(cache_key))
+    {
+        cache_stats.hits++;
+        return *entry;
+    }
+    cache_stats.misses++;
+
+    datum result;
+    if (translation && !untranslated)
+        result = _database_fetch(translation->get(), key);
+    if (result.dsize <= 0)
+        result = _database_fetch(_db, key);
+
+    db_entry entry;
+    if (result.dsize > 0)
+    {
+        entry.found = true;
+        entry.text = string((const char *)result.dptr, result.dsize);
+    }
+    return cache.insert(cache_key, move(entry));
+}
+
 // ----------------------------------------------------------------------
 // DB system
 // ----------------------------------------------------------------------
@@ -336,6 +449,16 @@ void databaseSystemShutdown()
         AllDBs[i].shutdown(true);
 }
 
+const db_cache_stats &databaseCacheStats()
+{
+    return cache_stats;
+}
+
+void databaseResetCacheStats()
+{
+    cache_stats = db_cache_stats();
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Main DB functions
 
@@ -545,12 +668,11 @@ static void _store_text_db(const string &in, DBM *db)
     _parse_text_db(inf, db);
 }
 
-static string _chooseStrByWeight(const string &entry, int fixed_weight = -1)
+static void _split_weighted_entry(db_entry &entry)
 {
-    vector<string> parts;
-    vector<int>    weights;
+    entry.split = true;
 
-    vector<string> lines = split_string("\n", entry, false, true);
+    vector<string> lines = split_string("\n", entry.text, false, true);
 
     int total_weight = 0;
     for (int i = 0, size = lines.size(); i < size; i++)
@@ -570,7 +692,10 @@ static string _chooseStrByWeight(const string &entry, int fixed_weight = -1)
         {
             i++;
             if (i == size)
-                return "BUG, WEIGHT AT END OF ENTRY";
+            {
+                entry.error = "BUG, WEIGHT AT END OF ENTRY";
+                return;
+            }
         }
         else
             weight = 10;
@@ -584,22 +709,32 @@ static string _chooseStrByWeight(const string &entry, int fixed_weight = -1)
         }
         trim_string(part);
 
-        parts.push_back(part);
-        weights.push_back(total_weight);
+        entry.parts.push_back(part);
+        entry.weights.push_back(total_weight);
     }
 
-    if (parts.empty())
-        return "BUG, EMPTY ENTRY";
+    if (entry.parts.empty())
+        entry.error = "BUG, EMPTY ENTRY";
+}
+
+static string _chooseStrByWeight(db_entry &entry, int fixed_weight = -1)
+{
+    if (!entry.split)
+        _split_weighted_entry(entry);
+
+    if (entry.error)
+        return entry.error;
 
+    const int total_weight = entry.weights.back();
     int choice = 0;
     if (fixed_weight != -1)
         choice = fixed_weight % total_weight;
     else
         choice = random2(total_weight);
 
-    for (int i = 0, size = parts.size(); i < size; i++)
-        if (choice < weights[i])
-            return parts[i];
+    for (int i = 0, size = entry.parts.size(); i < size; i++)
+        if (choice < entry.weights[i])
+            return entry.parts[i];
 
     return "BUG, NO STRING CHOSEN";
 }
@@ -616,33 +751,22 @@ static string _getWeightedString(TextDB &db, const string &key,
     lowercase(canonical_key);
 
     // Query the DB.
-    datum result;
-
-    if (db.translation)
-        result = _database_fetch(db.translation->get(), canonical_key);
-    if (result.dsize <= 0)
-        result = _database_fetch(db.get(), canonical_key);
+    db_entry *entry = &db.fetch(canonical_key);
 
-    if (result.dsize <= 0)
+    if (!entry->found)
     {
         // Try ignoring the suffix.
         canonical_key = key;
         lowercase(canonical_key);
 
         // Query the DB.
-        if (db.translation)
-            result = _database_fetch(db.translation->get(), canonical_key);
-        if (result.dsize <= 0)
-            result = _database_fetch(db.get(), canonical_key);
+        entry = &db.fetch(canonical_key);
 
-        if (result.dsize <= 0)
+        if (!entry->found)
             return "";
     }
 
-    // Cons up a (C++) string to return. The caller must release it.
-    string str = string((const char *)result.dptr, result.dsize);
-
-    return _chooseStrByWeight(str, fixed_weight);
+    return _chooseStrByWeight(*entry, fixed_weight);
 }
 
 static void _call_recursive_replacement(string &str, TextDB &db,
@@ -730,17 +854,11 @@ static string _query_database(TextDB &db, string key, bool canonicalise_key,
     }
 
     // Query the DB.
-    datum result;
-
-    if (db.translation && !untranslated)
-        result = _database_fetch(db.translation->get(), key);
-    if (result.dsize <= 0)
-        result = _database_fetch(db.get(), key);
-
-    if (result.dsize <= 0)
+    const db_entry &entry = db.fetch(key, untranslated);
+    if (!entry.found)
         return "";
 
-    string str((const char *)result.dptr, result.dsize);
+    string str = entry.text;
 
     // <foo> is an alias to key foo
     if (str[0] == '<' && str[str.size() - 2] == '>'
@@ -30,6 +30,19 @@ extern "C" {
 void databaseSystemInit();
 void databaseSystemShutdown();
 
+// Lookups answered by the in-memory entry cache (see db_cache_size).
+struct db_cache_stats
+{
+    db_cache_stats() : hits(0), misses(0), evictions(0) { }
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+};
+
+const db_cache_stats &databaseCacheStats();
+void databaseResetCacheStats();
+
 typedef bool (*db_find_filter)(string key, string body);
 
 string getQuoteString(const string &key);
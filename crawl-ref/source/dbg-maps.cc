@@ -47,6 +47,11 @@ static int build_attempts = 0, level_vetoes = 0;
 // Map from message to counts.
 static map<string, int> veto_messages;
 
+// Map selections, and the work the candidate indices saved.
+static int map_selections = 0;
+static uint64_t selection_candidates = 0, selection_maps = 0;
+static double selection_index_time = 0, selection_scan_time = 0;
+
 void mapstat_report_map_build_start()
 {
     build_attempts++;
@@ -279,6 +284,16 @@ bool mapstat_build_levels()
     return true;
 }
 
+void mapstat_report_map_selection(size_t candidates, size_t maps,
+                                  double index_time, double scan_time)
+{
+    map_selections++;
+    selection_candidates += candidates;
+    selection_maps += maps;
+    selection_index_time += index_time;
+    selection_scan_time += scan_time;
+}
+
 void mapstat_report_map_try(const map_def &map)
 {
     try_count[map.name]++;
@@ -341,6 +356,17 @@ static void _write_map_stats()
     fprintf(outf, "Levels attempted: %d, built: %d, failed: %d\n",
             levels_tried, levels_tried - levels_failed,
             levels_failed);
+    if (map_selections)
+    {
+        fprintf(outf, "Map selections: %d, maps checked: %" PRIu64 " of %"
+                      PRIu64 " (%.1f%%)\n",
+                map_selections, selection_candidates, selection_maps,
+                selection_candidates * 100.0 / max<uint64_t>(selection_maps, 1));
+        fprintf(outf, "Selection time: %.3fs indexed, %.3fs full scan, "
+                      "%.3fs saved\n",
+                selection_index_time, selection_scan_time,
+                selection_scan_time - selection_index_time);
+    }
     if (!errors.empty())
     {
         fprintf(outf, "\n\nMap errors:\n");
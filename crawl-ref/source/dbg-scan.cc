@@ -516,6 +516,19 @@ void debug_mons_scan()
         }
     }
 
+    const vector<unsigned short> &used = env.mons_used;
+    ASSERT(is_sorted(used.begin(), used.end()));
+    for (int i = 0; i < MAX_MONSTERS; ++i)
+    {
+        const monster &m(env.mons[i]);
+        if (m.type != MONS_NO_MONSTER
+            && !binary_search(used.begin(), used.end(), i))
+        {
+            die("used monster slot list is missing %s mindex=%d mid=%d",
+                m.name(DESC_PLAIN, true).c_str(), i, m.mid);
+        }
+    }
+
     if (in_bounds(you.pos()))
         if (const monster* m = monster_at(you.pos()))
             if (!m->submerged() && !fedhas_passthrough(m))
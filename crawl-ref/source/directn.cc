@@ -1397,7 +1397,7 @@ bool direction_chooser::select(bool allow_out_of_range, bool endpoint)
 
 bool direction_chooser::pickup_item()
 {
-    item_def *ii = nullptr;
+    const item_def *ii = nullptr;
     if (in_bounds(target()))
         ii = env.map_knowledge(target()).item();
     if (!ii || !ii->is_valid(true))
@@ -1405,7 +1405,8 @@ bool direction_chooser::pickup_item()
         mprf(MSGCH_EXAMINE_FILTER, "You can't see any item there.");
         return false;
     }
-    ii->flags |= ISFLAG_THROWN; // make autoexplore greedy
+    // make autoexplore greedy
+    env.map_knowledge(target()).mutable_item()->flags |= ISFLAG_THROWN;
 
     // From this point, if there's no item, we'll fake one. False info means
     // it's out of bounds and taken, or a mimic.
@@ -2504,7 +2505,7 @@ void full_describe_square(const coord_def &c, bool cleanup)
     int quantity = 0;
 
     const monster_info *mi = env.map_knowledge(c).monsterinfo();
-    item_def *obj = env.map_knowledge(c).item();
+    const item_def *obj = env.map_knowledge(c).item();
     const dungeon_feature_type feat = env.map_knowledge(c).feat();
 
     if (mi)
@@ -2536,7 +2537,10 @@ void full_describe_square(const coord_def &c, bool cleanup)
         if (mi)
             describe_monsters(*mi);
         else if (list_items.size())
-            describe_item(*obj);
+        {
+            item_def item = *obj;
+            describe_item(item);
+        }
         else
             describe_feature_wide(c);
     }
@@ -30,10 +30,12 @@
 #include "prompt.h"
 #include "religion.h"
 #include "startup.h"
+#include "stash.h"
 #include "state.h"
 #include "stringutil.h"
 #include "tag-version.h"
 #include "tilepick.h"
+#include "travel.h"
 #include "view.h"
 #include "xom.h"
 #include "ui.h"
@@ -234,6 +236,9 @@ NORETURN void end(int exit_code, bool print_error, const char *format, ...)
 void delete_files()
 {
     crawl_state.need_save = false;
+    // The morgue may still want level data that's only in the save.
+    travel_cache.load_all_levels();
+    StashTrack.load_all_levels();
     you.save->unlink();
     delete you.save;
     you.save = 0;
@@ -106,6 +106,11 @@ struct crawl_environment
     // Mapping mid->mindex until the transition is finished.
     map<mid_t, unsigned short> mid_cache;
 
+    // Sorted indices of the env.mons slots that are in use, so that
+    // monster_iterator need not scan every slot. A superset of the live
+    // monsters: slots are added when handed out and removed when reset.
+    vector<unsigned short> mons_used;
+
     // Things to happen when the current attack/etc finishes.
     vector<final_effect *> final_effects;
 
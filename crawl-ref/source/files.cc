@@ -2319,6 +2319,7 @@ static void _save_game_base()
 {
     /* Stashes */
     SAVEFILE("st", "stashes", StashTrack.save);
+    StashTrack.save_levels(you.save);
 
     /* lua */
     SAVEFILE("lua", "lua", clua.save); // what goes in here?
@@ -2328,6 +2329,7 @@ static void _save_game_base()
 
     /* travel cache */
     SAVEFILE("tc", "travel_cache", travel_cache.save);
+    travel_cache.save_levels(you.save);
 
     /* notes */
     SAVEFILE("nts", "notes", save_notes);
@@ -3110,6 +3112,23 @@ bool is_existing_level(const level_id &level)
     return you.save && you.save->has_chunk(level.describe());
 }
 
+// Level-scoped data such as travel cache and stash entries is saved in a
+// chunk per level, so that it can stay in the save until it's needed.
+string level_chunk_name(const string &prefix, const level_id &lid)
+{
+    return prefix + "-" + lid.describe();
+}
+
+// Delete the level chunks under prefix that aren't in keep.
+void delete_stale_level_chunks(package *save, const string &prefix,
+                               const set<string> &keep)
+{
+    const string start = prefix + "-";
+    for (const string &chunk : save->list_chunks())
+        if (starts_with(chunk, start) && !keep.count(chunk))
+            save->delete_chunk(chunk);
+}
+
 void delete_level(const level_id &level)
 {
     travel_cache.erase_level_info(level);
@@ -99,6 +99,10 @@ void save_game_state();
 void write_save_version(writer &file, save_version version);
 save_version get_save_version(reader &file);
 
+string level_chunk_name(const string &prefix, const level_id &lid);
+void delete_stale_level_chunks(package *save, const string &prefix,
+                               const set<string> &keep);
+
 bool save_exists(const string& filename);
 bool restore_game(const string& filename);
 
@@ -17,6 +17,7 @@
 #include "json-wrapper.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cinttypes>
 #include <cctype>
 #include <cstdio>
@@ -260,6 +261,7 @@ const vector<GameOption*> game_options::build_options_list()
         new IntGameOption(SIMPLE_NAME(hp_warning), 30, 0, 100),
         new IntGameOption(magic_point_warning, {"mp_warning"}, 0, 0, 100),
         new IntGameOption(SIMPLE_NAME(autofight_warning), 0, 0, 1000),
+        new IntGameOption(SIMPLE_NAME(db_cache_size), 2048, 0),
         // These need to be odd, hence allow +1.
         new IntGameOption(SIMPLE_NAME(view_max_width),
                       max(VIEW_BASE_WIDTH, VIEW_MIN_WIDTH),
@@ -4115,6 +4117,7 @@ enum es_command_type
     ES_PUT,
     ES_REPACK,
     ES_INFO,
+    ES_BENCH,
     NUM_ES
 };
 
@@ -4143,6 +4146,7 @@ static edit_command<es_command_type> es_commands[] =
     { ES_RM,      "rm",      true,  1, 1, },
     { ES_REPACK,  "repack",  false, 0, 0, },
     { ES_INFO,    "info",    false, 0, 0, },
+    { ES_BENCH,   "bench",   false, 0, 1, },
 };
 
 static edit_command<eb_command_type> eb_commands[] =
@@ -4153,6 +4157,28 @@ static edit_command<eb_command_type> eb_commands[] =
     { EB_REWRITE,  "rewrite", true,  0, 1 },
 };
 
+// Read and decompress every chunk of the save, count times over. Returns
+// the time taken in seconds, and the uncompressed size of one pass in len.
+static double _time_save_load(package &save, int count, uint64_t &len)
+{
+    const vector<string> chunks = save.list_chunks();
+    char buf[16384];
+
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+    {
+        len = 0;
+        for (const string &chunk : chunks)
+        {
+            chunk_reader in(&save, chunk);
+            while (plen_t s = in.read(buf, sizeof(buf)))
+                len += s;
+        }
+    }
+    const chrono::duration<double> taken = chrono::steady_clock::now() - start;
+    return taken.count();
+}
+
 #define FAIL(...) do { fprintf(stderr, __VA_ARGS__); return; } while (0)
 static void _edit_save(int argc, char **argv)
 {
@@ -4166,6 +4192,8 @@ static void _edit_save(int argc, char **argv)
                "     <chunkfile> defaults to \"chunk\"; use \"-\" for stdout/stdin\n"
                "  rm <chunk>                  delete a chunk\n"
                "  repack                      defrag and reclaim unused space\n"
+               "  bench [<count>]             time loading every chunk <count>\n"
+               "                              times, with and without mmap\n"
              );
         return;
     }
@@ -4313,6 +4341,32 @@ static void _edit_save(int argc, char **argv)
             // there's also wasted space due to fragmentation, but since
             // it's linear, there's no need to print it
         }
+        else if (cmd == ES_BENCH)
+        {
+            const int count = (argc == 3) ? atoi(argv[2]) : 20;
+            if (count <= 0)
+                FAIL("Invalid count \"%s\".\n", argv[2]);
+
+            printf("Loading all chunks of a %u byte save, %d times:\n",
+                   save.get_size(), count);
+            for (bool use_mmap : { false, true })
+            {
+                save.set_mmap(use_mmap);
+                uint64_t len = 0;
+                // Once to warm the page cache, so both ways start even.
+                _time_save_load(save, 1, len);
+                if (use_mmap && !save.uses_mmap())
+                {
+                    printf("  %-6s unavailable, the save can't be mapped\n",
+                           "mmap");
+                    continue;
+                }
+                const double secs = _time_save_load(save, count, len);
+                printf("  %-6s %8.3f ms/load %8.1f MB/s\n",
+                       use_mmap ? "mmap" : "read", secs * 1000 / count,
+                       len * count / secs / (1024 * 1024));
+            }
+        }
     }
     catch (ext_fail_exception &fe)
     {
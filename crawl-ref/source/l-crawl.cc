@@ -10,6 +10,7 @@
 #include "chardump.h"
 #include "cluautil.h"
 #include "command.h"
+#include "database.h"
 #include "delay.h"
 #include "directn.h"
 #include "dlua.h"
@@ -1819,6 +1820,23 @@ LUAFN(crawl_rng_wrap)
 
 LUAWRAP(crawl_clear_message_store, clear_message_store())
 
+/*** Counters for the in-memory text database cache.
+ * @treturn int lookups answered from the cache
+ * @treturn int lookups that went to the database
+ * @treturn int entries evicted to make room
+ * @function db_cache_stats
+ */
+static int crawl_db_cache_stats(lua_State *ls)
+{
+    const db_cache_stats &stats = databaseCacheStats();
+    lua_pushnumber(ls, stats.hits);
+    lua_pushnumber(ls, stats.misses);
+    lua_pushnumber(ls, stats.evictions);
+    return 3;
+}
+
+LUAWRAP(crawl_reset_db_cache_stats, databaseResetCacheStats())
+
 
 static const struct luaL_reg crawl_dlib[] =
 {
@@ -1838,6 +1856,8 @@ static const struct luaL_reg crawl_dlib[] =
 { "unavailable_god", _crawl_unavailable_god },
 { "rng_wrap", crawl_rng_wrap },
 { "clear_message_store", crawl_clear_message_store },
+{ "db_cache_stats", crawl_db_cache_stats },
+{ "reset_db_cache_stats", crawl_reset_db_cache_stats },
 
 { nullptr, nullptr }
 };
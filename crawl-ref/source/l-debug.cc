@@ -5,7 +5,10 @@
 
 #include "l-libs.h"
 
+#include <chrono>
+
 #include "act-iter.h"
+#include "beam.h"
 #include "branch.h"
 #include "chardump.h"
 #include "cluautil.h"
@@ -20,13 +23,16 @@
 #include "mon-act.h"
 #include "mon-cast.h"
 #include "mon-death.h"
+#include "mon-pathfind.h"
 #include "mon-poly.h"
 #include "ng-setup.h"
 #include "religion.h"
+#include "shout.h"
 #include "stairs.h"
 #include "state.h"
 #include "stringutil.h"
 #include "tileview.h"
+#include "travel.h"
 #include "unwind.h"
 #include "view.h"
 #include "wiz-dgn.h"
@@ -283,6 +289,204 @@ LUAFN(debug_handle_monster_move)
     return 0;
 }
 
+// Seconds taken by a call to f.
+template<class F>
+static double _time_call(F f)
+{
+    const auto start = chrono::steady_clock::now();
+    f();
+    const chrono::duration<double> elapsed =
+        chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+/*** Time monster pathfinding towards the player.
+ * Every monster on the level searches for a path to the player, as it
+ * would when tracking a foe, the given number of times.
+ * @tparam int rounds
+ * @tparam[opt=false] boolean shared whether monsters may share distance
+ *   fields, as they do when chasing something; each round counts as a turn
+ * @treturn number seconds taken
+ * @treturn int paths found
+ * @function time_pathfind
+ */
+LUAFN(debug_time_pathfind)
+{
+    const int rounds = luaL_checkint(ls, 1);
+    const bool shared = lua_toboolean(ls, 2);
+    int found = 0;
+
+    const double seconds = _time_call([&]
+    {
+        for (int i = 0; i < rounds; ++i)
+        {
+            invalidate_pathfind_fields();
+            for (monster_iterator mi; mi; ++mi)
+            {
+                monster_pathfind mp;
+                mp.set_range(mons_tracking_range(*mi));
+                if (shared ? mp.init_shared_pathfind(*mi, you.pos())
+                           : mp.init_pathfind(*mi, you.pos()))
+                {
+                    mp.calc_waypoints();
+                    ++found;
+                }
+            }
+        }
+    });
+
+    lua_pushnumber(ls, seconds);
+    lua_pushnumber(ls, found);
+    return 2;
+}
+
+/*** Time near iteration around every monster on the level.
+ * Each round, every monster looks for the actors and monsters it can see.
+ * @tparam int rounds
+ * @tparam[opt=true] boolean indexed whether to start from the monsters
+ *   the monster grid has in range, rather than checking every slot
+ * @treturn number seconds taken
+ * @treturn int actors found
+ * @function time_near_iterators
+ */
+LUAFN(debug_time_near_iterators)
+{
+    const int rounds = luaL_checkint(ls, 1);
+    const bool indexed = lua_isnoneornil(ls, 2) || lua_toboolean(ls, 2);
+    int found = 0;
+
+    set_near_iterator_index(indexed);
+    const double seconds = _time_call([&]
+    {
+        for (int i = 0; i < rounds; ++i)
+        {
+            for (monster_iterator mi; mi; ++mi)
+            {
+                for (actor_near_iterator ai(*mi); ai; ++ai)
+                    ++found;
+                for (monster_near_iterator ni(mi->pos(), LOS_NO_TRANS); ni;
+                     ++ni)
+                {
+                    ++found;
+                }
+            }
+        }
+    });
+    set_near_iterator_index(true);
+
+    lua_pushnumber(ls, seconds);
+    lua_pushnumber(ls, found);
+    return 2;
+}
+
+/*** Time travel back and forth across the mapped level.
+ * The level is magic mapped, then the player travels between the two
+ * squares the given number of times, taking the steps explore and travel
+ * would.
+ * @tparam int rounds
+ * @tparam int x1
+ * @tparam int y1
+ * @tparam int x2
+ * @tparam int y2
+ * @tparam[opt=true] boolean reuse whether steps may reuse the travel flood
+ *   of earlier steps
+ * @treturn number seconds taken
+ * @treturn int steps taken
+ * @treturn int a checksum of the squares travelled through
+ * @function time_travel
+ */
+LUAFN(debug_time_travel)
+{
+    const int rounds = luaL_checkint(ls, 1);
+    const coord_def ends[2] =
+    {
+        coord_def(luaL_checkint(ls, 2), luaL_checkint(ls, 3)),
+        coord_def(luaL_checkint(ls, 4), luaL_checkint(ls, 5)),
+    };
+    const bool reuse = lua_isnoneornil(ls, 6) || lua_toboolean(ls, 6);
+    int steps = 0;
+    int checksum = 0;
+
+    magic_mapping(1000, 100, true, true);
+    you.moveto(ends[0]);
+    set_travel_flood_reuse(reuse);
+    const double seconds = _time_call([&]
+    {
+        for (int i = 0; i < rounds; ++i)
+        {
+            you.running = RMODE_TRAVEL;
+            you.running.pos = ends[!(i % 2)];
+            while (you.pos() != you.running.pos)
+            {
+                int move_x = 0, move_y = 0;
+                find_travel_pos(you.pos(), &move_x, &move_y);
+                if (!move_x && !move_y)
+                    break;
+                you.moveto(you.pos() + coord_def(move_x, move_y));
+                checksum = (checksum * 31 + you.pos().x * GYM + you.pos().y)
+                           % 1000003;
+                ++steps;
+            }
+        }
+    });
+    set_travel_flood_reuse(true);
+    you.running.clear();
+
+    lua_pushnumber(ls, seconds);
+    lua_pushnumber(ls, steps);
+    lua_pushnumber(ls, checksum);
+    return 3;
+}
+
+/*** Time propagating the noises made since the last call.
+ * Noises are made with dgn.noisy(), and apply_noises() then spreads them
+ * over the level as at the end of a turn.
+ * @treturn number seconds taken
+ * @function time_noises
+ */
+LUAFN(debug_time_noises)
+{
+    lua_pushnumber(ls, _time_call(apply_noises));
+    return 1;
+}
+
+/*** Time tracers between the player and every monster on the level.
+ * Each round, every monster traces a bolt of cold at the player, and the
+ * player traces a magic dart at every monster.
+ * @tparam int rounds
+ * @treturn number seconds taken
+ * @treturn int tracers fired
+ * @function time_tracers
+ */
+LUAFN(debug_time_tracers)
+{
+    const int rounds = luaL_checkint(ls, 1);
+    int fired = 0;
+
+    const double seconds = _time_call([&]
+    {
+        for (int i = 0; i < rounds; ++i)
+        {
+            for (monster_iterator mi; mi; ++mi)
+            {
+                bolt mbeam = mons_spell_beam(*mi, SPELL_BOLT_OF_COLD, 50);
+                mbeam.target = you.pos();
+                fire_tracer(*mi, mbeam);
+
+                bolt pbeam;
+                pbeam.source = you.pos();
+                pbeam.target = mi->pos();
+                player_tracer(ZAP_MAGIC_DART, 50, pbeam, LOS_RADIUS);
+                fired += 2;
+            }
+        }
+    });
+
+    lua_pushnumber(ls, seconds);
+    lua_pushnumber(ls, fired);
+    return 2;
+}
+
 static FixedBitVector<NUM_MONSTERS> saved_uniques;
 
 LUAFN(debug_save_uniques)
@@ -358,6 +562,19 @@ LUAFN(debug_viewwindow)
     return 0;
 }
 
+/*** How many cells of the view the last redraw drew.
+ * @treturn int cells drawn in the last frame
+ * @treturn int cells drawn since the game started
+ * @function view_cells_drawn
+ */
+LUAFN(debug_view_cells_drawn)
+{
+    uint64_t total;
+    lua_pushnumber(ls, view_cells_drawn(&total));
+    lua_pushnumber(ls, total);
+    return 2;
+}
+
 LUAWRAP(debug_seen_monsters_react, seen_monsters_react())
 
 static const char* disablements[] =
@@ -555,11 +772,17 @@ const struct luaL_reg debug_dlib[] =
 { "dismiss_monsters", debug_dismiss_monsters},
 { "god_wrath", debug_god_wrath},
 { "handle_monster_move", debug_handle_monster_move },
+{ "time_pathfind", debug_time_pathfind },
+{ "time_near_iterators", debug_time_near_iterators },
+{ "time_travel", debug_time_travel },
+{ "time_noises", debug_time_noises },
+{ "time_tracers", debug_time_tracers },
 { "save_uniques", debug_save_uniques },
 { "randomize_uniques", debug_randomize_uniques },
 { "reset_uniques", debug_reset_uniques },
 { "check_uniques", debug_check_uniques },
 { "viewwindow", debug_viewwindow },
+{ "view_cells_drawn", debug_view_cells_drawn },
 { "seen_monsters_react", debug_seen_monsters_react },
 { "disable", debug_disable },
 { "cpp_assert", debug_cpp_assert },
@@ -88,6 +88,8 @@ static int dgn_depth_proc(lua_State *ls, depth_ranges &dr, int s)
 static int dgn_depth(lua_State *ls)
 {
     MAP(ls, 1, map);
+    if (lua_gettop(ls) > 1)
+        map_selection_changed(*map);
     return dgn_depth_proc(ls, map->depths, 2);
 }
 
@@ -96,6 +98,7 @@ static int dgn_place(lua_State *ls)
     MAP(ls, 1, map);
     if (lua_gettop(ls) > 1)
     {
+        map_selection_changed(*map);
         if (lua_isnil(ls, 2))
             map->place.clear();
         else
@@ -5,6 +5,8 @@
 
 #include "l-libs.h"
 
+#include <chrono>
+
 #include "cluautil.h"
 #include "coord.h"
 #include "losglobal.h"
@@ -57,11 +59,59 @@ LUAFN(los_cell_see_cell)
     PLUARET(number, cell_see_cell(p, q, LOS_DEFAULT));
 }
 
+/*** Benchmark losight() around a cell.
+ * @tparam int x
+ * @tparam int y
+ * @tparam int n number of calls
+ * @tparam[opt=true] boolean vectorised use the word-parallel kernel
+ * @treturn number calls per second
+ * @function time_losight
+ */
+LUAFN(los_time_losight)
+{
+    COORDS(p, 1, 2);
+    const int n = luaL_safe_checkint(ls, 3);
+    const bool vectorised = lua_isnoneornil(ls, 4) || lua_toboolean(ls, 4);
+
+    los_grid sh;
+    set_los_vectorised(vectorised);
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i)
+        losight(sh, p, opc_default);
+    const chrono::duration<double> elapsed =
+        chrono::steady_clock::now() - start;
+    set_los_vectorised(true);
+
+    PLUARET(number, elapsed.count() > 0 ? n / elapsed.count() : 0);
+}
+
+/*** Counters for the global cell_see_cell() cache.
+ * @treturn int lookups answered from the cache
+ * @treturn int lookups that had to recompute LOS
+ * @treturn int invalidations
+ * @treturn int cached windows touched by invalidations
+ * @function cache_stats
+ */
+LUAFN(los_cache_stats)
+{
+    const globallos_stats &stats = get_globallos_stats();
+    lua_pushnumber(ls, stats.hits);
+    lua_pushnumber(ls, stats.misses);
+    lua_pushnumber(ls, stats.invalidations);
+    lua_pushnumber(ls, stats.windows_cleared);
+    return 4;
+}
+
+LUAWRAP(los_reset_cache_stats, reset_globallos_stats())
+
 const struct luaL_reg los_dlib[] =
 {
     { "findray", los_find_ray },
     { "make_ray", los_make_ray },
     { "cell_see_cell", los_cell_see_cell },
+    { "time_losight", los_time_losight },
+    { "cache_stats", los_cache_stats },
+    { "reset_cache_stats", los_reset_cache_stats },
     { nullptr, nullptr }
 };
 
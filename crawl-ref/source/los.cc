@@ -46,14 +46,19 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 #include "areas.h"
 #include "coord.h"
 #include "coordit.h"
 #include "env.h"
+#include "files.h"
 #include "losglobal.h"
 #include "mon-act.h"
 #include "mpr.h"
+#include "syscalls.h"
+#include "tags.h"
+#include "version.h"
 
 // These determine what rays are cast in the precomputation,
 // and affect start-up time significantly.
@@ -61,6 +66,12 @@
 #define LOS_MAX_ANGLE (2*LOS_MAX_RANGE-2)
 #define LOS_INTERCEPT_MULT (2)
 
+// The results of the precomputation are cached on disk in this file,
+// in the versioned save directory. Bump LOS_CACHE_FORMAT whenever the
+// layout of the cache changes.
+#define LOS_CACHE_FILE "los.cache"
+#define LOS_CACHE_FORMAT 1
+
 // These store all unique (in terms of footprint) full rays.
 // The footprint of ray=fullray[i] consists of ray.length cells,
 // stored in ray_coords[ray.start..ray.length-1].
@@ -436,6 +447,242 @@ static void _create_blockrays()
           n_cellrays, (unsigned int)fullrays.size(), n_min_rays);
 }
 
+static string _ray_cache_path()
+{
+    return savedir_versioned_path(LOS_CACHE_FILE);
+}
+
+// Doubles are stored bitwise, so that the cached rays are exactly the
+// ones we'd have computed.
+static void _marshall_double(writer &th, double d)
+{
+    uint64_t bits;
+    COMPILE_CHECK(sizeof(bits) == sizeof(d));
+    memcpy(&bits, &d, sizeof(bits));
+    marshallUnsigned(th, bits);
+}
+
+static double _unmarshall_double(reader &th)
+{
+    const uint64_t bits = unmarshallUnsigned(th);
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+static void _marshall_ray(writer &th, const los_ray &ray)
+{
+    _marshall_double(th, ray.r.start.x);
+    _marshall_double(th, ray.r.start.y);
+    _marshall_double(th, ray.r.dir.x);
+    _marshall_double(th, ray.r.dir.y);
+    marshallBoolean(th, ray.on_corner);
+    marshallUnsigned(th, ray.start);
+    marshallUnsigned(th, ray.length);
+}
+
+static los_ray _unmarshall_ray(reader &th)
+{
+    geom::ray r;
+    r.start.x = _unmarshall_double(th);
+    r.start.y = _unmarshall_double(th);
+    r.dir.x = _unmarshall_double(th);
+    r.dir.y = _unmarshall_double(th);
+    los_ray ray(r);
+    ray.on_corner = unmarshallBoolean(th);
+    unmarshallUnsigned(th, ray.start);
+    unmarshallUnsigned(th, ray.length);
+    return ray;
+}
+
+// Everything that the precomputation depends on: the LOS parameters,
+// and the code itself, as identified by the version string.
+static void _marshall_ray_cache_header(writer &th)
+{
+    write_save_version(th, save_version::current());
+    marshallInt(th, LOS_CACHE_FORMAT);
+    marshallInt(th, LOS_MAX_RANGE);
+    marshallInt(th, LOS_MAX_ANGLE);
+    marshallInt(th, LOS_INTERCEPT_MULT);
+    marshallString(th, Version::Long);
+}
+
+static bool _ray_cache_header_matches(reader &th)
+{
+    return get_save_version(th) == save_version::current()
+           && unmarshallInt(th) == LOS_CACHE_FORMAT
+           && unmarshallInt(th) == LOS_MAX_RANGE
+           && unmarshallInt(th) == LOS_MAX_ANGLE
+           && unmarshallInt(th) == LOS_INTERCEPT_MULT
+           && unmarshallString(th) == Version::Long;
+}
+
+// Try to fill fullrays, ray_coords, cellray_ends, blockrays and
+// min_cellrays from the cache file. Returns false, leaving them
+// untouched, if the cache is missing, stale or damaged.
+//
+// The tables are unpacked into this process's own vectors, so the cache
+// saves the precomputation but not the memory; the mapping is dropped
+// once they're filled.
+static bool _load_ray_cache()
+{
+    mapped_file cache(_ray_cache_path());
+    if (!cache.valid())
+        return false;
+
+    reader th(cache.data(), cache.size());
+    th.set_safe_read(true);
+
+    vector<los_ray> rays;
+    vector<coord_def> coords;
+    vector<coord_def> ends;
+    FixedArray<vector<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> minima;
+    blockrays_t blocks;
+    blocks.init(nullptr);
+    bool complete = false;
+
+    try
+    {
+        if (!_ray_cache_header_matches(th))
+            return false;
+
+        const uint64_t n_coords = unmarshallUnsigned(th);
+        for (uint64_t i = 0; i < n_coords; ++i)
+            coords.push_back(unmarshallCoord(th));
+
+        const uint64_t n_rays = unmarshallUnsigned(th);
+        for (uint64_t i = 0; i < n_rays; ++i)
+        {
+            rays.push_back(_unmarshall_ray(th));
+            if (rays.back().start + rays.back().length > coords.size())
+                return false;
+        }
+
+        const uint64_t n_min_rays = unmarshallUnsigned(th);
+        for (uint64_t i = 0; i < n_min_rays; ++i)
+            ends.push_back(unmarshallCoord(th));
+
+        for (quadrant_iterator qi; qi; ++qi)
+        {
+            const uint64_t n_cellrays = unmarshallUnsigned(th);
+            if (!n_cellrays)
+                return false;
+            for (uint64_t i = 0; i < n_cellrays; ++i)
+            {
+                const uint64_t ray = unmarshallUnsigned(th);
+                const uint64_t end = unmarshallUnsigned(th);
+                if (ray >= rays.size() || end >= rays[ray].length)
+                    return false;
+                cellray c(rays[ray], end);
+                c.imbalance = unmarshallInt(th);
+                c.first_diag = unmarshallBoolean(th);
+                minima(*qi).push_back(c);
+            }
+        }
+
+        // Blocking information is stored packed, eight rays to the byte.
+        vector<unsigned char> packed((n_min_rays + 7) / 8);
+        for (quadrant_iterator qi; qi; ++qi)
+        {
+            th.read(packed.data(), packed.size());
+            blocks(*qi) = new bit_vector(n_min_rays);
+            for (uint64_t i = 0; i < n_min_rays; ++i)
+                if (packed[i / 8] & (1 << (i % 8)))
+                    blocks(*qi)->set(i);
+        }
+        // Anything after the blocking information is junk.
+        complete = !th.valid();
+    }
+    catch (short_read_exception &E)
+    {
+    }
+
+    if (!complete)
+    {
+        for (quadrant_iterator qi; qi; ++qi)
+            delete blocks(*qi);
+        return false;
+    }
+
+    fullrays.swap(rays);
+    ray_coords.swap(coords);
+    cellray_ends.swap(ends);
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        min_cellrays(*qi).swap(minima(*qi));
+        blockrays(*qi) = blocks(*qi);
+    }
+
+    dead_rays  = new bit_vector(cellray_ends.size());
+    smoke_rays = new bit_vector(cellray_ends.size());
+
+    dprf("Loaded LOS rays from %s", _ray_cache_path().c_str());
+    return true;
+}
+
+static void _write_ray_cache()
+{
+    const string path = _ray_cache_path();
+    if (!dir_exists(get_parent_directory(path)))
+        return;
+
+    // Other processes may have the old file mapped, so the new one is
+    // written next to it and renamed into place. The lock only keeps
+    // concurrent writers apart.
+    file_lock lock(path + ".lk", "wb", false);
+    const string tmp = path + ".tmp";
+    FILE *fp = fopen_replace(tmp.c_str());
+    if (!fp)
+        return;
+
+    // The minimal cellrays refer to their full ray by index.
+    map<unsigned int, uint64_t> ray_index;
+    for (unsigned int i = 0; i < fullrays.size(); ++i)
+        ray_index[fullrays[i].start] = i;
+
+    writer th(tmp, fp, true);
+    _marshall_ray_cache_header(th);
+
+    marshallUnsigned(th, ray_coords.size());
+    for (const coord_def &c : ray_coords)
+        marshallCoord(th, c);
+
+    marshallUnsigned(th, fullrays.size());
+    for (const los_ray &ray : fullrays)
+        _marshall_ray(th, ray);
+
+    const unsigned int n_min_rays = cellray_ends.size();
+    marshallUnsigned(th, n_min_rays);
+    for (const coord_def &c : cellray_ends)
+        marshallCoord(th, c);
+
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        marshallUnsigned(th, min_cellrays(*qi).size());
+        for (const cellray &c : min_cellrays(*qi))
+        {
+            marshallUnsigned(th, ray_index[c.ray.start]);
+            marshallUnsigned(th, c.end);
+            marshallInt(th, c.imbalance);
+            marshallBoolean(th, c.first_diag);
+        }
+    }
+
+    vector<unsigned char> packed((n_min_rays + 7) / 8);
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        fill(packed.begin(), packed.end(), 0);
+        for (unsigned int i = 0; i < n_min_rays; ++i)
+            if (blockrays(*qi)->get(i))
+                packed[i / 8] |= 1 << (i % 8);
+        th.write(packed.data(), packed.size());
+    }
+
+    const bool closed = !fclose(fp);
+    if (!th.succeeded() || !closed || rename_u(tmp.c_str(), path.c_str()))
+        unlink_u(tmp.c_str());
+}
+
 static int _gcd(int x, int y)
 {
     int tmp;
@@ -461,9 +708,15 @@ static void raycast()
     if (done_raycast)
         return;
 
+    done_raycast = true;
+
+    // The precomputation is deterministic, so it's usually been done by
+    // an earlier process already.
+    if (_load_ray_cache())
+        return;
+
     // Creating all rays for first quadrant
     // We have a considerable amount of overkill.
-    done_raycast = true;
 
     // register perpendiculars FIRST, to make them top choice
     // when selecting beams
@@ -505,6 +758,8 @@ static void raycast()
 
     // Now create the appropriate blockrays array
     _create_blockrays();
+
+    _write_ray_cache();
 }
 
 static int _imbalance(ray_def ray, const coord_def& target)
@@ -792,6 +1047,15 @@ bool cell_see_cell_nocache(const coord_def& p1, const coord_def& p2)
 // Smoke will now only block LOS after two cells of smoke. This is
 // done by updating with a second array.
 
+// Whether opaque cells' blockrays are united by the word-parallel kernel,
+// or one at a time. Only changed for benchmarking.
+static bool los_vectorised = true;
+
+void set_los_vectorised(bool vectorised)
+{
+    los_vectorised = vectorised;
+}
+
 static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy)
 {
     const unsigned int num_cellrays = cellray_ends.size();
@@ -799,6 +1063,11 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
     dead_rays->reset();
     smoke_rays->reset();
 
+    // The rays blocked by opaque cells don't depend on the order we visit
+    // them in, so they're collected and united in a single pass below.
+    const bit_vector *opaque[(LOS_MAX_RANGE+1) * (LOS_MAX_RANGE+1)];
+    int num_opaque = 0;
+
     for (quadrant_iterator qi; qi; ++qi)
     {
         coord_def p = coord_def(sx*(qi->x), sy*(qi->y));
@@ -809,7 +1078,7 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
         {
         case OPC_OPAQUE:
             // Block the appropriate rays.
-            *dead_rays |= *blockrays(*qi);
+            opaque[num_opaque++] = blockrays(*qi);
             break;
         case OPC_HALF:
             // Block rays which have already seen a cloud.
@@ -820,6 +1089,7 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
             break;
         }
     }
+    dead_rays->unite(opaque, num_opaque, los_vectorised);
 
     // Ray calculation done. Now work out which cells in this
     // quadrant are visible.
@@ -2,6 +2,7 @@
 
 #include "losglobal.h"
 
+#include "bitary.h"
 #include "coord.h"
 #include "coordit.h"
 #include "libutil.h"
@@ -17,6 +18,12 @@ typedef halflos_t globallos_t[GXM][GYM];
 
 static globallos_t globallos;
 
+// Which windows of globallos hold any known entries. Invalidation only
+// needs to look at these; the rest are all zero already.
+static FixedBitArray<GXM, GYM> populated;
+
+static globallos_stats stats;
+
 static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
 {
     COMPILE_CHECK(LOS_KNOWN * 2 <= sizeof(losfield_t) * 8);
@@ -28,9 +35,15 @@ static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
         return nullptr;
     // p < q iff p.x < q.x || p.x == q.x && p.y < q.y
     if (diff < coord_def(0, 0))
+    {
+        populated.set(q);
         return &globallos[q.x][q.y][-diff.x + o_half_x][-diff.y + o_half_y];
+    }
     else
+    {
+        populated.set(p);
         return &globallos[p.x][p.y][ diff.x + o_half_x][ diff.y + o_half_y];
+    }
 }
 
 static void _save_los(los_def* los, los_type l)
@@ -59,21 +72,62 @@ static void _save_los(los_def* los, los_type l)
 }
 
 // Opacity at p has changed.
+//
+// Whether q can be seen from o only depends on the cells in the rectangle
+// spanned by o and q, since every ray between them stays inside it. So in
+// each window that could mention p, we only forget the pairs whose
+// rectangle contains p.
 void invalidate_los_around(const coord_def& p)
 {
+    stats.invalidations++;
+
     int x1 = max(p.x - LOS_MAX_RANGE, 0);
     int y1 = max(p.y - LOS_MAX_RANGE, 0);
     int x2 = min(p.x, GXM - 1);
     int y2 = min(p.y + LOS_MAX_RANGE, GYM - 1);
     for (int y = y1; y <= y2; y++)
         for (int x = x1; x <= x2; x++)
-            memset(globallos[x][y], 0, sizeof(halflos_t));
+        {
+            if (!populated(x, y))
+                continue;
+
+            stats.windows_cleared++;
+            halflos_t &half = globallos[x][y];
+            // The pair (o, o + d) is affected iff d.x >= p.x - o.x, and d.y
+            // lies on p's side of o, at least as far out. On p's own row,
+            // that's every d.y.
+            const int dy = p.y - y;
+            const int ylo = dy > 0 ? dy : -LOS_MAX_RANGE;
+            const int yhi = dy < 0 ? dy : LOS_MAX_RANGE;
+            for (int dx = p.x - x; dx <= LOS_MAX_RANGE; dx++)
+            {
+                memset(&half[dx + o_half_x][ylo + o_half_y], 0,
+                       (yhi - ylo + 1) * sizeof(losfield_t));
+            }
+        }
 }
 
 void invalidate_los()
 {
+    stats.invalidations++;
     for (rectangle_iterator ri(0); ri; ++ri)
+    {
+        if (!populated(*ri))
+            continue;
+        stats.windows_cleared++;
         memset(globallos[ri->x][ri->y], 0, sizeof(halflos_t));
+    }
+    populated.reset();
+}
+
+const globallos_stats &get_globallos_stats()
+{
+    return stats;
+}
+
+void reset_globallos_stats()
+{
+    stats = globallos_stats();
 }
 
 static void _update_globallos_at(const coord_def& p, los_type l)
@@ -124,7 +178,12 @@ bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
         return false; // outside range
 
     if (!(*flags & (l << LOS_KNOWN)))
+    {
+        stats.misses++;
         _update_globallos_at(p, l);
+    }
+    else
+        stats.hits++;
 
     ASSERT(*flags & (l << LOS_KNOWN));
     return *flags & l;
@@ -5,4 +5,16 @@
 void invalidate_los_around(const coord_def& p);
 void invalidate_los();
 
+// Counters for the effectiveness of the cell_see_cell() cache.
+struct globallos_stats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;          // lookups that recomputed a window
+    uint64_t invalidations = 0;   // calls to invalidate_los{,_around}
+    uint64_t windows_cleared = 0; // populated windows touched by those
+};
+
+const globallos_stats &get_globallos_stats();
+void reset_globallos_stats();
+
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l);
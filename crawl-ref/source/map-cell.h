@@ -1,5 +1,9 @@
 #pragma once
 
+#include <memory> // unique_ptr
+#include <new>
+#include <vector>
+
 #include "enum.h"
 #include "mon-info.h"
 #include "tag-version.h"
@@ -57,6 +61,106 @@ struct cloud_info
     killer_type killer;
 };
 
+/*
+ * Fixed-size blocks carved from large slabs and recycled through a free
+ * list, so that map knowledge updates do not go to the general-purpose
+ * allocator. Blocks are never returned to the system.
+ */
+class map_cell_slab
+{
+public:
+    explicit map_cell_slab(size_t size);
+
+    void *allocate();
+    void release(void *block);
+
+private:
+    size_t block_size;
+    vector<unique_ptr<char[]>> slabs;
+    void *free_list;
+};
+
+/*
+ * A reference-counted copy of the monster, item or cloud a map_cell
+ * remembers. Copies of a map_cell share their payloads, and a map_cell
+ * only writes to one it holds the sole reference to.
+ */
+template <typename T>
+struct map_cell_payload
+{
+    T value;
+    int refs;
+
+    static map_cell_payload *create(const T &v)
+    {
+        return new (slab().allocate()) map_cell_payload(v);
+    }
+
+    map_cell_payload *share()
+    {
+        ++refs;
+        return this;
+    }
+
+    void release()
+    {
+        if (--refs)
+            return;
+        this->~map_cell_payload();
+        slab().release(this);
+    }
+
+private:
+    explicit map_cell_payload(const T &v) : value(v), refs(1) { }
+
+    static map_cell_slab &slab()
+    {
+        // Deliberately leaked: map cells in globals outlive any static.
+        static map_cell_slab *s = new map_cell_slab(sizeof(map_cell_payload));
+        return *s;
+    }
+};
+
+// Point p at a payload holding v, reusing p's block if nothing shares it.
+template <typename T>
+static inline void set_map_cell_payload(map_cell_payload<T> *&p, const T &v)
+{
+    if (p && p->refs == 1)
+        p->value = v;
+    else
+    {
+        if (p)
+            p->release();
+        p = map_cell_payload<T>::create(v);
+    }
+}
+
+// Drop p's reference to its payload, if any.
+template <typename T>
+static inline void clear_map_cell_payload(map_cell_payload<T> *&p)
+{
+    if (p)
+    {
+        p->release();
+        p = nullptr;
+    }
+}
+
+// Give p a payload of its own, copying the shared one, and return its value.
+template <typename T>
+static inline T *unshare_map_cell_payload(map_cell_payload<T> *&p)
+{
+    if (!p)
+        return nullptr;
+    if (p->refs > 1)
+    {
+        map_cell_payload<T> *copy = map_cell_payload<T>::create(p->value);
+        p->release();
+        p = copy;
+    }
+    return &p->value;
+}
+
 /*
  * A map_cell stores what the player knows about a cell.
  * These go in env.map_knowledge.
@@ -71,41 +175,21 @@ struct map_cell
     map_cell(const map_cell& c)
     {
         memcpy(this, &c, sizeof(map_cell));
-        if (_cloud)
-            _cloud = new cloud_info(*_cloud);
-        if (_mons)
-            _mons = new monster_info(*_mons);
-        if (_item)
-            _item = new item_def(*_item);
+        _share_payloads();
     }
 
     ~map_cell()
     {
-        if (_cloud)
-            delete _cloud;
-        if (!(flags & MAP_DETECTED_MONSTER) && _mons)
-            delete _mons;
-        if (_item)
-            delete _item;
+        _release_payloads();
     }
 
     map_cell& operator=(const map_cell& c)
     {
         if (&c == this)
             return *this;
-        if (_cloud)
-            delete _cloud;
-        if (_mons)
-            delete _mons;
-        if (_item)
-            delete _item;
+        _release_payloads();
         memcpy(this, &c, sizeof(map_cell));
-        if (_cloud)
-            _cloud = new cloud_info(*_cloud);
-        if (_mons)
-            _mons = new monster_info(*_mons);
-        if (_item)
-            _item = new item_def(*_item);
+        _share_payloads();
         return *this;
     }
 
@@ -154,9 +238,16 @@ struct map_cell
         _trap = tr;
     }
 
-    item_def* item() const
+    const item_def* item() const
     {
-        return _item;
+        return _item ? &_item->value : nullptr;
+    }
+
+    // The remembered item, for changing it without affecting copies of
+    // this cell.
+    item_def* mutable_item()
+    {
+        return unshare_map_cell_payload(_item);
     }
 
     bool detected_item() const
@@ -173,8 +264,8 @@ struct map_cell
 
     void set_item(const item_def& ii, bool more_items)
     {
-        clear_item();
-        _item = new item_def(ii);
+        flags &= ~(MAP_DETECTED_ITEM | MAP_MORE_ITEMS);
+        set_map_cell_payload(_item, ii);
         if (more_items)
             flags |= MAP_MORE_ITEMS;
     }
@@ -183,31 +274,32 @@ struct map_cell
 
     void clear_item()
     {
-        if (_item)
-        {
-            delete _item;
-            _item = 0;
-        }
+        clear_map_cell_payload(_item);
         flags &= ~(MAP_DETECTED_ITEM | MAP_MORE_ITEMS);
     }
 
     monster_type monster() const
     {
         if (_mons)
-            return _mons->type;
+            return _mons->value.type;
         else
             return MONS_NO_MONSTER;
     }
 
-    monster_info* monsterinfo() const
+    const monster_info* monsterinfo() const
+    {
+        return _mons ? &_mons->value : nullptr;
+    }
+
+    monster_info* mutable_monsterinfo()
     {
-        return _mons;
+        return unshare_map_cell_payload(_mons);
     }
 
     void set_monster(const monster_info& mi)
     {
-        clear_monster();
-        _mons = new monster_info(mi);
+        flags &= ~(MAP_DETECTED_MONSTER | MAP_INVISIBLE_MONSTER);
+        set_map_cell_payload(_mons, mi);
     }
 
     bool detected_monster() const
@@ -222,9 +314,8 @@ struct map_cell
 
     void set_detected_monster(monster_type mons)
     {
-        clear_monster();
-        _mons = new monster_info(MONS_SENSED);
-        _mons->base_type = mons;
+        set_monster(monster_info(MONS_SENSED));
+        _mons->value.base_type = mons;
         flags |= MAP_DETECTED_MONSTER;
     }
 
@@ -236,16 +327,14 @@ struct map_cell
 
     void clear_monster()
     {
-        if (_mons)
-            delete _mons;
+        clear_map_cell_payload(_mons);
         flags &= ~(MAP_DETECTED_MONSTER | MAP_INVISIBLE_MONSTER);
-        _mons = 0;
     }
 
     cloud_type cloud() const
     {
         if (_cloud)
-            return _cloud->type;
+            return _cloud->value.type;
         else
             return CLOUD_NONE;
     }
@@ -253,30 +342,29 @@ struct map_cell
     unsigned cloud_colour() const
     {
         if (_cloud)
-            return _cloud->colour;
+            return _cloud->value.colour;
         else
             return 0;
     }
 
-    cloud_info* cloudinfo() const
+    const cloud_info* cloudinfo() const
+    {
+        return _cloud ? &_cloud->value : nullptr;
+    }
+
+    cloud_info* mutable_cloudinfo()
     {
-        return _cloud;
+        return unshare_map_cell_payload(_cloud);
     }
 
     void set_cloud(const cloud_info& ci)
     {
-        if (_cloud)
-            delete _cloud;
-        _cloud = new cloud_info(ci);
+        set_map_cell_payload(_cloud, ci);
     }
 
     void clear_cloud()
     {
-        if (_cloud)
-        {
-            delete _cloud;
-            _cloud = 0;
-        }
+        clear_map_cell_payload(_cloud);
     }
 
     bool update_cloud_state();
@@ -314,10 +402,27 @@ struct map_cell
 public:
     uint32_t flags;   // Flags describing the mappedness of this square.
 private:
+    void _share_payloads()
+    {
+        if (_cloud)
+            _cloud->share();
+        if (_item)
+            _item->share();
+        if (_mons)
+            _mons->share();
+    }
+
+    void _release_payloads()
+    {
+        clear_map_cell_payload(_cloud);
+        clear_map_cell_payload(_item);
+        clear_map_cell_payload(_mons);
+    }
+
     dungeon_feature_type _feat:8;
     colour_t _feat_colour;
     trap_type _trap:8;
-    cloud_info* _cloud;
-    item_def* _item;
-    monster_info* _mons;
+    map_cell_payload<cloud_info>* _cloud;
+    map_cell_payload<item_def>* _item;
+    map_cell_payload<monster_info>* _mons;
 };
@@ -168,13 +168,43 @@ void clear_terrain_visibility()
     env.visible.clear();
 }
 
+map_cell_slab::map_cell_slab(size_t size)
+    : block_size(max(size, sizeof(void *))), free_list(nullptr)
+{
+    // Keep every block in a slab aligned for any type.
+    const size_t align = alignof(max_align_t);
+    block_size = (block_size + align - 1) / align * align;
+}
+
+void *map_cell_slab::allocate()
+{
+    if (!free_list)
+    {
+        const int blocks_per_slab = 64;
+        slabs.emplace_back(new char[block_size * blocks_per_slab]);
+        char *slab = slabs.back().get();
+        for (int i = 0; i < blocks_per_slab; ++i)
+            release(slab + i * block_size);
+    }
+
+    void *block = free_list;
+    free_list = *static_cast<void **>(block);
+    return block;
+}
+
+void map_cell_slab::release(void *block)
+{
+    *static_cast<void **>(block) = free_list;
+    free_list = block;
+}
+
 void map_cell::set_detected_item()
 {
-    clear_item();
+    item_def detected;
+    detected.base_type = OBJ_DETECTED;
+    detected.rnd       = 1;
+    set_item(detected, false);
     flags |= MAP_DETECTED_ITEM;
-    _item = new item_def();
-    _item->base_type = OBJ_DETECTED;
-    _item->rnd       = 1;
 }
 
 static bool _floor_mf(map_feature mf)
@@ -309,8 +339,8 @@ bool map_cell::update_cloud_state()
         return false; // we're already up-to-date
 
     // player non-opaque clouds vanish instantly out of los
-    if (_cloud && _cloud->killer == KILL_YOU_MISSILE
-        && !is_opaque_cloud(_cloud->type))
+    if (_cloud && _cloud->value.killer == KILL_YOU_MISSILE
+        && !is_opaque_cloud(_cloud->value.type))
     {
         clear_cloud();
         return true;
@@ -2986,6 +2986,7 @@ bool map_def::is_usable_in(const level_id &lid) const
 void map_def::add_depth(const level_range &range)
 {
     depths.add_depth(range);
+    map_selection_changed(*this);
 }
 
 bool map_def::has_depth() const
@@ -2998,6 +2999,7 @@ void map_def::update_cached_tags()
     cache_minivault = has_tag("minivault");
     cache_overwritable = has_tag("overwritable");
     cache_extra = has_tag("extra");
+    map_selection_changed(*this);
 }
 
 bool map_def::is_minivault() const
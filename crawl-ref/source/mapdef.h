@@ -975,6 +975,7 @@ public:
     void write(writer &) const;
     void clear() { depths.clear(); }
     bool empty() const { return depths.empty(); }
+    const depth_ranges_v &ranges() const { return depths; }
     bool is_usable_in(const level_id &lid) const;
     void add_depth(const level_range &range) { depths.push_back(range); }
     void add_depths(const depth_ranges &other_ranges);
@@ -8,8 +8,10 @@
 #include "maps.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <unordered_map>
 #include <sys/param.h>
 #include <sys/types.h>
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
@@ -738,6 +740,159 @@ vector<string> find_map_matches(const string &name)
     return matches;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Candidate indices for map selection.
+//
+// Rather than asking every map whether it is acceptable, selection starts
+// from the maps that could possibly match: those carrying all the wanted
+// tags, or those with a DEPTH (or PLACE) range covering the level. The
+// full checks still apply to each candidate. Candidates are kept in vdefs
+// order, so the eligible maps - and therefore seeded dungeons - come out
+// exactly as a full scan would have them.
+
+typedef vector<unsigned> vault_indices;
+
+class map_depth_index
+{
+public:
+    void clear();
+    void add(unsigned index, const depth_ranges &ranges);
+    // nullptr if the place is outside the index and every map has to be
+    // considered.
+    const vault_indices *find(const level_id &place) const;
+
+private:
+    void add_level(branch_type br, int depth, unsigned index);
+
+    // Indexed by branch and depth - 1.
+    FixedVector<vector<vault_indices>, NUM_BRANCHES> levels;
+};
+
+void map_depth_index::clear()
+{
+    for (vector<vault_indices> &branch : levels)
+    {
+        branch.clear();
+        branch.resize(MAX_BRANCH_DEPTH);
+    }
+}
+
+void map_depth_index::add_level(branch_type br, int depth, unsigned index)
+{
+    vault_indices &maps = levels[br][depth - 1];
+    // Several ranges of one map may cover the same level.
+    if (maps.empty() || maps.back() != index)
+        maps.push_back(index);
+}
+
+void map_depth_index::add(unsigned index, const depth_ranges &ranges)
+{
+    for (const level_range &lr : ranges.ranges())
+    {
+        // Denials can only rule a level out.
+        if (lr.deny)
+            continue;
+
+        // Absolute depths depend on where branches turn up, and BRANCH_END
+        // on how deep the branch is, so both are filed under every level
+        // they could conceivably cover.
+        if (lr.branch == NUM_BRANCHES)
+        {
+            for (branch_iterator it; it; ++it)
+                for (int depth = 1; depth <= MAX_BRANCH_DEPTH; ++depth)
+                    add_level(it->id, depth, index);
+            continue;
+        }
+
+        const int shallowest = lr.shallowest == BRANCH_END
+                               ? 1 : max(lr.shallowest, 1);
+        const int deepest = min(lr.deepest, MAX_BRANCH_DEPTH);
+        for (int depth = shallowest; depth <= deepest; ++depth)
+            add_level(lr.branch, depth, index);
+    }
+}
+
+const vault_indices *map_depth_index::find(const level_id &place) const
+{
+    if (place.branch < 0 || place.branch >= NUM_BRANCHES
+        || place.depth < 1 || place.depth > MAX_BRANCH_DEPTH)
+    {
+        return nullptr;
+    }
+    return &levels[place.branch][place.depth - 1];
+}
+
+static bool map_indices_stale = true;
+static map_depth_index maps_by_depth;
+static map_depth_index maps_by_place;
+static unordered_map<string, vault_indices> maps_by_tag;
+
+static void _check_map_indices()
+{
+    if (!map_indices_stale)
+        return;
+
+    maps_by_depth.clear();
+    maps_by_place.clear();
+    maps_by_tag.clear();
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+    {
+        const map_def &mapdef = vdefs[i];
+        maps_by_depth.add(i, mapdef.depths);
+        maps_by_place.add(i, mapdef.place);
+        for (const string &tag : mapdef.get_tags())
+            maps_by_tag[tag].push_back(i);
+    }
+    map_indices_stale = false;
+}
+
+// Lua can edit the tags, depths and places of the loaded maps in place,
+// which the indices above must hear about. Edits to copies don't matter.
+void map_selection_changed(const map_def &map)
+{
+    if (&map >= vdefs.data() && &map < vdefs.data() + vdefs.size())
+        map_indices_stale = true;
+}
+
+// The maps with all the given tags. Returns nullptr if there were no tags
+// to go on; scratch holds the result if more than one tag was needed.
+static const vault_indices *_maps_with_tags(const unordered_set<string> &tags,
+                                            vault_indices &scratch)
+{
+    static const vault_indices none;
+
+    _check_map_indices();
+
+    vector<const vault_indices *> lists;
+    for (const string &tag : tags)
+    {
+        auto it = maps_by_tag.find(tag);
+        if (it == maps_by_tag.end())
+            return &none;
+        lists.push_back(&it->second);
+    }
+    if (lists.empty())
+        return nullptr;
+
+    sort(lists.begin(), lists.end(),
+         [](const vault_indices *a, const vault_indices *b)
+         { return a->size() < b->size(); });
+    if (lists.size() == 1)
+        return lists[0];
+
+    scratch = *lists[0];
+    vault_indices merged;
+    for (unsigned i = 1; i < lists.size() && !scratch.empty(); ++i)
+    {
+        merged.clear();
+        set_intersection(scratch.begin(), scratch.end(),
+                         lists[i]->begin(), lists[i]->end(),
+                         back_inserter(merged));
+        scratch.swap(merged);
+    }
+    return &scratch;
+}
+
 mapref_vector find_maps_for_tag(const string &tag,
                                 bool check_depth,
                                 bool check_used)
@@ -746,7 +901,7 @@ mapref_vector find_maps_for_tag(const string &tag,
     level_id place = level_id::current();
     unordered_set<string> tag_set = parse_tags(tag);
 
-    for (const map_def &mapdef : vdefs)
+    auto check = [&](const map_def &mapdef)
     {
         if (mapdef.has_all_tags(tag_set.begin(), tag_set.end())
             && !mapdef.has_tag("dummy")
@@ -757,6 +912,18 @@ mapref_vector find_maps_for_tag(const string &tag,
         {
             maps.push_back(&mapdef);
         }
+    };
+
+    vault_indices scratch;
+    if (const vault_indices *candidates = _maps_with_tags(tag_set, scratch))
+    {
+        for (unsigned i : *candidates)
+            check(vdefs[i]);
+    }
+    else
+    {
+        for (const map_def &mapdef : vdefs)
+            check(mapdef);
     }
     return maps;
 }
@@ -774,6 +941,7 @@ private:
 
 public:
     bool accept(const map_def &md) const;
+    const vault_indices *candidates(vault_indices &scratch) const;
     void announce(const map_def *map) const;
 
     bool valid() const
@@ -917,6 +1085,25 @@ bool map_selector::accept(const map_def &mapdef) const
     }
 }
 
+// The only maps accept() could possibly pass, in vdefs order, or nullptr
+// if all of them need checking.
+const vault_indices *map_selector::candidates(vault_indices &scratch) const
+{
+    _check_map_indices();
+    switch (sel)
+    {
+    case PLACE:
+        return maps_by_place.find(place);
+    case DEPTH:
+    case DEPTH_AND_CHANCE:
+        return maps_by_depth.find(place);
+    case TAG:
+        return _maps_with_tags(parse_tags(tag), scratch);
+    default:
+        return nullptr;
+    }
+}
+
 void map_selector::announce(const map_def *vault) const
 {
 #ifdef DEBUG_DIAGNOSTICS
@@ -957,18 +1144,52 @@ string vault_chance_tag(const map_def &map)
     return "";
 }
 
-typedef vector<unsigned> vault_indices;
+static vault_indices _eligible_maps_by_scan(const map_selector &sel)
+{
+    vault_indices eligible;
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+        if (sel.accept(vdefs[i]))
+            eligible.push_back(i);
+    return eligible;
+}
 
 static vault_indices _eligible_maps_for_selector(const map_selector &sel)
 {
     vault_indices eligible;
 
-    if (sel.valid())
+    if (!sel.valid())
+        return eligible;
+
+#ifdef DEBUG_STATISTICS
+    const auto start = chrono::steady_clock::now();
+#endif
+
+    vault_indices scratch;
+    const vault_indices *candidates = sel.candidates(scratch);
+    if (candidates)
     {
-        for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+        for (unsigned i : *candidates)
             if (sel.accept(vdefs[i]))
                 eligible.push_back(i);
     }
+    else
+        eligible = _eligible_maps_by_scan(sel);
+
+#ifdef DEBUG_STATISTICS
+    if (crawl_state.map_stat_gen)
+    {
+        const auto indexed = chrono::steady_clock::now();
+        // Time the scan this replaces, and make sure it agrees.
+        const vault_indices scanned = _eligible_maps_by_scan(sel);
+        const chrono::duration<double> index_time = indexed - start;
+        const chrono::duration<double> scan_time =
+            chrono::steady_clock::now() - indexed;
+        ASSERT(scanned == eligible);
+        mapstat_report_map_selection(
+            candidates ? candidates->size() : vdefs.size(), vdefs.size(),
+            index_time.count(), scan_time.count());
+    }
+#endif
 
     return eligible;
 }
@@ -1436,6 +1657,258 @@ static void _write_map_cache(const string &filename, size_t vs, size_t ve,
     _write_map_index(descache_base, vs, ve, mtime);
 }
 
+////////////////////////////////////////////////////////////////////////////
+// The consolidated vault index.
+//
+// Every .des file also gets a section in one shared index file, holding
+// the same prelude and map headers as its .lux and .idx. Startup maps that
+// file once and reads each section straight out of the mapping; only files
+// whose mtime no longer matches fall back to the per-file caches (or a
+// reparse). Map bodies stay in the per-file .dsc and are loaded on demand.
+//
+// The headers are still unmarshalled into vdefs, so what this saves is the
+// file opens and version checks, not the memory the map_defs take; the
+// mapping itself is dropped once read_maps() is done.
+
+#define VAULT_INDEX_FILE "vaults.idx"
+// Bump this if the layout of the index itself changes.
+#define VAULT_INDEX_FORMAT 1
+
+struct vault_index_entry
+{
+    time_t mtime;
+    size_t offset;
+    size_t size;
+};
+
+struct vault_index_section
+{
+    string cache_name;
+    time_t mtime;
+    vector<unsigned char> data;
+};
+
+static bool building_vault_index = false;
+static shared_ptr<mapped_file> vault_index_map;
+static int vault_index_minor = TAG_MINOR_INVALID;
+static map<string, vault_index_entry> vault_index;
+static vector<vault_index_section> vault_index_sections;
+static bool vault_index_dirty = false;
+
+static void _open_vault_index()
+{
+    vault_index_map.reset();
+    vault_index.clear();
+    vault_index_sections.clear();
+    vault_index_dirty = false;
+
+    _check_des_index_dir();
+    const string path = _des_cache_dir(VAULT_INDEX_FILE);
+    file_lock lock(path + ".lk", "rb", false);
+    auto mapping = make_shared<mapped_file>(path);
+    if (!mapping->valid())
+    {
+        vault_index_dirty = true;
+        return;
+    }
+
+    try
+    {
+        reader inf(mapping->data(), mapping->size());
+        const auto version = get_save_version(inf);
+        if (version.major != TAG_MAJOR_VERSION
+            || version.minor > TAG_MINOR_VERSION
+            || unmarshallByte(inf) != WORD_LEN
+            || unmarshallByte(inf) != VAULT_INDEX_FORMAT)
+        {
+            vault_index_dirty = true;
+            return;
+        }
+        inf.setMinorVersion(version.minor);
+        vault_index_minor = version.minor;
+
+        const int nfiles = unmarshallInt(inf);
+        vector<pair<string, vault_index_entry>> toc;
+        size_t total = 0;
+        for (int i = 0; i < nfiles; ++i)
+        {
+            const string name = unmarshallString(inf);
+            vault_index_entry entry;
+            entry.mtime  = unmarshallSigned(inf);
+            entry.size   = unmarshallInt(inf);
+            entry.offset = total;
+            total += entry.size;
+            toc.emplace_back(name, entry);
+        }
+
+        // The sections follow the table of contents back to back.
+        if (total > mapping->size())
+        {
+            vault_index_dirty = true;
+            return;
+        }
+        const size_t base = mapping->size() - total;
+        for (auto &file : toc)
+        {
+            file.second.offset += base;
+            vault_index[file.first] = file.second;
+        }
+    }
+    catch (short_read_exception &E)
+    {
+        vault_index.clear();
+        vault_index_dirty = true;
+        return;
+    }
+
+    vault_index_map = mapping;
+    dprf("Mapped vault index with %u files", (unsigned int)vault_index.size());
+}
+
+static bool _load_vault_index_section(const string &cache_name, time_t mtime)
+{
+    auto it = vault_index.find(cache_name);
+    if (!vault_index_map || it == vault_index.end()
+        || it->second.mtime != mtime)
+    {
+        return false;
+    }
+
+    // The map bodies are still read from the .dsc when a map is used, so
+    // it has to be as current as the index, as _load_map_cache() checks.
+    _check_des_index_dir();
+    const string descache_base = get_descache_path(cache_name, "");
+    file_lock deslock(descache_base + ".lk", "rb", false);
+    if (!_verify_map_full(descache_base, mtime))
+        return false;
+
+    const vault_index_entry &entry = it->second;
+    const unsigned char *data = vault_index_map->data() + entry.offset;
+    const size_t nexist = vdefs.size();
+    const size_t npreludes = global_preludes.size();
+    vector<string> names;
+    try
+    {
+        reader inf(data, entry.size, vault_index_minor);
+        if (unmarshallBoolean(inf))
+        {
+            lc_global_prelude.read(inf);
+            global_preludes.push_back(lc_global_prelude);
+        }
+
+        const int nmaps = unmarshallInt(inf);
+        vdefs.resize(nexist + nmaps, map_def());
+        for (int i = 0; i < nmaps; ++i)
+        {
+            map_def &vdef(vdefs[nexist + i]);
+            vdef.read_index(inf);
+            vdef.description = unmarshallString(inf);
+            vdef.order = unmarshallInt(inf);
+
+            vdef.set_file(cache_name);
+            lc_loaded_maps[vdef.name] = vdef.place_loaded_from;
+            names.push_back(vdef.name);
+            vdef.place_loaded_from.clear();
+        }
+    }
+    catch (short_read_exception &E)
+    {
+        // Leave things as they were for the fallback to load the file.
+        vdefs.resize(nexist);
+        global_preludes.erase(global_preludes.begin() + npreludes,
+                              global_preludes.end());
+        for (const string &name : names)
+            lc_loaded_maps.erase(name);
+        return false;
+    }
+
+    // Still current, so carry it over to the next index verbatim.
+    vault_index_sections.push_back(
+        { cache_name, mtime,
+          vector<unsigned char>(data, data + entry.size) });
+    return true;
+}
+
+// Add a section for the maps in vdefs[vs...] that came from somewhere other
+// than the consolidated index.
+static void _add_vault_index_section(const string &cache_name, time_t mtime,
+                                     size_t vs, const dlua_chunk *prelude)
+{
+    vault_index_sections.push_back({ cache_name, mtime, {} });
+    writer outf(&vault_index_sections.back().data);
+
+    marshallBoolean(outf, prelude && !prelude->empty());
+    if (prelude && !prelude->empty())
+        prelude->write(outf);
+
+    marshallInt(outf, vdefs.size() - vs);
+    for (size_t i = vs; i < vdefs.size(); ++i)
+    {
+        map_def &vdef = vdefs[i];
+        // Maps read from a per-file index have already handed their
+        // location over to lc_loaded_maps.
+        const map_file_place place =
+            vdef.place_loaded_from.filename.empty()
+                ? lc_loaded_maps[vdef.name] : vdef.place_loaded_from;
+        unwind_var<map_file_place> loaded_from(vdef.place_loaded_from, place);
+        vdef.write_index(outf);
+        marshallString(outf, vdef.description);
+        marshallInt(outf, vdef.order);
+    }
+
+    vault_index_dirty = true;
+}
+
+static void _write_vault_index()
+{
+    // Files that have gone away leave stale entries behind.
+    if (vault_index_sections.size() != vault_index.size())
+        vault_index_dirty = true;
+
+    // Drop the old mapping before replacing the file underneath it.
+    vault_index_map.reset();
+    vault_index.clear();
+
+    if (!vault_index_dirty)
+    {
+        vault_index_sections.clear();
+        return;
+    }
+
+    // As with the LOS ray cache, other processes may have the old index
+    // mapped, so the new one is written alongside and renamed into place.
+    const string path = _des_cache_dir(VAULT_INDEX_FILE);
+    file_lock lock(path + ".lk", "wb", false);
+    const string tmp = path + ".tmp";
+    FILE *fp = fopen_replace(tmp.c_str());
+    if (!fp)
+    {
+        vault_index_sections.clear();
+        return;
+    }
+
+    writer outf(tmp, fp, true);
+    write_save_version(outf, save_version::current());
+    marshallByte(outf, WORD_LEN);
+    marshallByte(outf, VAULT_INDEX_FORMAT);
+    marshallInt(outf, vault_index_sections.size());
+    for (const vault_index_section &section : vault_index_sections)
+    {
+        marshallString(outf, section.cache_name);
+        marshallSigned(outf, section.mtime);
+        marshallInt(outf, section.data.size());
+    }
+    for (const vault_index_section &section : vault_index_sections)
+        outf.write(section.data.data(), section.data.size());
+
+    const bool closed = !fclose(fp);
+    if (!outf.succeeded() || !closed || rename_u(tmp.c_str(), path.c_str()))
+        unlink_u(tmp.c_str());
+
+    vault_index_sections.clear();
+    vault_index_dirty = false;
+}
+
 static void _parse_maps(const string &s)
 {
     string cache_name = get_cache_name(s);
@@ -1444,7 +1917,24 @@ static void _parse_maps(const string &s)
 
     map_files_read.insert(cache_name);
 
-    if (_load_map_cache(s, cache_name))
+    if (building_vault_index)
+    {
+        const time_t mtime = file_modtime(s);
+        if (_load_vault_index_section(cache_name, mtime))
+            return;
+
+        const size_t file_start = vdefs.size();
+        const size_t npreludes = global_preludes.size();
+        if (_load_map_cache(s, cache_name))
+        {
+            _add_vault_index_section(cache_name, mtime, file_start,
+                                     global_preludes.size() > npreludes
+                                         ? &global_preludes.back()
+                                         : nullptr);
+            return;
+        }
+    }
+    else if (_load_map_cache(s, cache_name))
         return;
 
     FILE *dat = fopen_u(s.c_str(), "r");
@@ -1470,11 +1960,17 @@ static void _parse_maps(const string &s)
 
     global_preludes.push_back(lc_global_prelude);
 
+    if (building_vault_index)
+    {
+        _add_vault_index_section(cache_name, mtime, file_start,
+                                 &lc_global_prelude);
+    }
     _write_map_cache(cache_name, file_start, vdefs.size(), mtime);
 }
 
 void read_map(const string &file)
 {
+    map_indices_stale = true;
     _parse_maps(lc_desfile = datafile_path(file));
     _dgn_flush_map_environments();
     // Force GC to prevent heap from swelling unnecessarily.
@@ -1483,8 +1979,13 @@ void read_map(const string &file)
 
 void read_maps()
 {
-    if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
-        end(1, false, "Lua error: %s", dlua.error.c_str());
+    _open_vault_index();
+    {
+        unwind_bool building(building_vault_index, true);
+        if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
+            end(1, false, "Lua error: %s", dlua.error.c_str());
+    }
+    _write_vault_index();
 
     lc_loaded_maps.clear();
 
@@ -1509,6 +2010,7 @@ void reread_maps()
 
     // BOOM!
     vdefs.clear();
+    map_indices_stale = true;
     map_files_read.clear();
     read_maps();
 }
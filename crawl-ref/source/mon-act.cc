@@ -2300,8 +2300,9 @@ static void _clear_monster_flags()
     // monsters get their actions in the next round.
     // Also clear one-turn deep sleep flag.
     // XXX: MF_JUST_SLEPT only really works for player-cast hibernation.
-    for (auto &mons : menv_real)
-        mons.flags &= ~MF_JUST_SUMMONED & ~MF_JUST_SLEPT;
+    // Slots that are not in use have already had their flags reset.
+    for (unsigned short idx : env.mons_used)
+        env.mons[idx].flags &= ~MF_JUST_SUMMONED & ~MF_JUST_SLEPT;
 }
 
 /**
@@ -47,6 +47,7 @@
 #include "mon-behv.h"
 #include "mon-explode.h"
 #include "mon-gear.h"
+#include "mon-pathfind.h"
 #include "mon-place.h"
 #include "mon-poly.h"
 #include "mon-speak.h"
@@ -2487,6 +2488,10 @@ void monster_cleanup(monster* mons)
         invalidate_agrid();
     }
 
+    // Shared monster paths route around stationary monsters.
+    if (mons->is_stationary())
+        invalidate_pathfind_fields();
+
     // May have been constricting something. No message because that depends
     // on the order in which things are cleaned up: If the constrictee is
     // cleaned up first, we wouldn't get a message anyway.
@@ -2,6 +2,7 @@
 
 #include "mon-pathfind.h"
 
+#include "coordit.h"
 #include "directn.h"
 #include "env.h"
 #include "los.h"
@@ -59,16 +60,253 @@ int mons_tracking_range(const monster* mon)
     return range;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// pathfind_workspace
+
+#define PATHFIND_CELLS (GXM * GYM)
+
+// Scratch space for searches. Monsters pathfind every turn, so rather than
+// allocating and clearing the arrays for every search, workspaces are
+// pooled and everything in them is stamped with the search it belongs to;
+// anything with an older stamp is treated as untouched.
+//
+// The open set is a bucket queue keyed by estimated total path length.
+// Each bucket is a list threaded through the cells themselves, newest
+// first, so queueing and requeueing positions never allocates.
+class pathfind_workspace
+{
+public:
+    pathfind_workspace() : search(0), stamp(), queued(), bucket_stamp() { }
+
+    void begin_search();
+
+    int dist(const coord_def &p) const
+    {
+        const int c = _cell(p);
+        return stamp[c] == search ? distance[c] : INFINITE_DISTANCE;
+    }
+
+    void set_dist(const coord_def &p, int d)
+    {
+        const int c = _cell(p);
+        stamp[c]    = search;
+        distance[c] = d;
+    }
+
+    // Only meaningful for positions with a distance.
+    int &prev(const coord_def &p) { return back_dir[_cell(p)]; }
+    int prev(const coord_def &p) const { return back_dir[_cell(p)]; }
+
+    bool bucket_empty(int bucket) const
+    {
+        return bucket_stamp[bucket] != search || head[bucket] == -1;
+    }
+
+    void push(const coord_def &p, int bucket);
+    void remove(const coord_def &p, int bucket);
+    coord_def pop(int bucket);
+
+private:
+    static int _cell(const coord_def &p) { return p.x * GYM + p.y; }
+    static coord_def _pos(int c) { return coord_def(c / GYM, c % GYM); }
+
+    uint32_t search;
+    uint32_t stamp[PATHFIND_CELLS];
+    // Stamped with the current search while the cell is in a bucket.
+    uint32_t queued[PATHFIND_CELLS];
+    int distance[PATHFIND_CELLS];
+    int back_dir[PATHFIND_CELLS];
+
+    uint32_t bucket_stamp[PATHFIND_CELLS];
+    int head[PATHFIND_CELLS];
+    // Links of each queued cell within its bucket.
+    int next[PATHFIND_CELLS];
+    int before[PATHFIND_CELLS];
+};
+
+void pathfind_workspace::begin_search()
+{
+    if (++search == 0)
+    {
+        // Wrapped around: stale stamps could now look current.
+        memset(stamp, 0, sizeof(stamp));
+        memset(queued, 0, sizeof(queued));
+        memset(bucket_stamp, 0, sizeof(bucket_stamp));
+        search = 1;
+    }
+}
+
+void pathfind_workspace::push(const coord_def &p, int bucket)
+{
+    ASSERT(bucket >= 0 && bucket < PATHFIND_CELLS);
+    if (bucket_stamp[bucket] != search)
+    {
+        bucket_stamp[bucket] = search;
+        head[bucket] = -1;
+    }
+
+    const int c = _cell(p);
+    queued[c] = search;
+    next[c]   = head[bucket];
+    before[c] = -1;
+    if (head[bucket] != -1)
+        before[head[bucket]] = c;
+    head[bucket] = c;
+}
+
+void pathfind_workspace::remove(const coord_def &p, int bucket)
+{
+    // Positions that have already been looked at are no longer queued.
+    const int c = _cell(p);
+    if (queued[c] != search)
+        return;
+
+    ASSERT(!bucket_empty(bucket));
+    queued[c] = 0;
+    if (before[c] == -1)
+        head[bucket] = next[c];
+    else
+        next[before[c]] = next[c];
+    if (next[c] != -1)
+        before[next[c]] = before[c];
+}
+
+coord_def pathfind_workspace::pop(int bucket)
+{
+    ASSERT(!bucket_empty(bucket));
+    const int c = head[bucket];
+    queued[c] = 0;
+    head[bucket] = next[c];
+    if (head[bucket] != -1)
+        before[head[bucket]] = -1;
+    return _pos(c);
+}
+
+// Workspaces not currently lent to a monster_pathfind. Searches don't
+// nest deeply, so this stays tiny.
+static vector<unique_ptr<pathfind_workspace>> workspace_pool;
+
+static pathfind_workspace *_acquire_workspace()
+{
+    if (workspace_pool.empty())
+        return new pathfind_workspace;
+
+    pathfind_workspace *ws = workspace_pool.back().release();
+    workspace_pool.pop_back();
+    return ws;
+}
+
+static void _release_workspace(pathfind_workspace *ws)
+{
+    workspace_pool.emplace_back(ws);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Shared distance fields
+//
+// A band of monsters chasing the player would each run the same search
+// towards nearly the same spot. Instead, once a second monster of a kind
+// wants a path to a given cell in a turn, a distance field is flooded
+// outwards from that cell, and every monster of that kind reads its path
+// straight off the field.
+//
+// Which cells a monster can pass and what they cost depends on its habitat,
+// flight and whether it can open doors; all of that follows from its type,
+// so fields are shared by hostile monsters of the same type, base type,
+// flight, attitude and berserk state. Stationary monsters block paths too,
+// so placing or killing one throws the fields away.
+//
+// Whether a monster will step on a mechanical trap can depend on where it
+// stands and how hurt it is (see monster::is_trap_safe), which a field can't
+// hold. Monsters that would have to make that call on the current level
+// search on their own; the rest (brainless or berserk ones, or any monster
+// on a level without such traps) share as usual.
+
+struct pathfind_field_key
+{
+    coord_def target;
+    int range;
+    monster_type type;
+    monster_type base;
+    bool airborne;
+    mon_attitude_type attitude;
+    bool berserk;
+
+    bool operator == (const pathfind_field_key &other) const
+    {
+        return target == other.target && range == other.range
+               && type == other.type && base == other.base
+               && airborne == other.airborne && attitude == other.attitude
+               && berserk == other.berserk;
+    }
+};
+
+struct pathfind_field
+{
+    pathfind_field_key key;
+    // Only worth building once a second monster asks for it.
+    int requests;
+    bool built;
+    // Cost of the cheapest path from each cell to the target.
+    int dist[PATHFIND_CELLS];
+};
+
+#define MAX_PATHFIND_FIELDS 32
+
+// Fields in use this turn are the first fields_used; the rest are kept
+// around to be reused.
+static vector<unique_ptr<pathfind_field>> fields;
+static int fields_used = 0;
+static int fields_time = -1;
+static level_id fields_level;
+
+static int _field_cell(const coord_def &p)
+{
+    return p.x * GYM + p.y;
+}
+
+void invalidate_pathfind_fields()
+{
+    fields_used = 0;
+}
+
+static pathfind_field *_find_field(const pathfind_field_key &key)
+{
+    if (fields_time != you.elapsed_time
+        || fields_level != level_id::current())
+    {
+        fields_used  = 0;
+        fields_time  = you.elapsed_time;
+        fields_level = level_id::current();
+    }
+
+    for (int i = 0; i < fields_used; ++i)
+        if (fields[i]->key == key)
+            return fields[i].get();
+
+    if (fields_used == MAX_PATHFIND_FIELDS)
+        return nullptr;
+
+    if (fields_used == (int)fields.size())
+        fields.emplace_back(new pathfind_field);
+    pathfind_field *field = fields[fields_used++].get();
+    field->key      = key;
+    field->requests = 0;
+    field->built    = false;
+    return field;
+}
+
 //#define DEBUG_PATHFIND
 monster_pathfind::monster_pathfind()
     : mons(nullptr), start(), target(), pos(), allow_diagonals(true),
       traverse_unmapped(false), range(0), min_length(0), max_length(0),
-      dist(), prev(), hash()
+      ws(_acquire_workspace())
 {
 }
 
 monster_pathfind::~monster_pathfind()
 {
+    _release_workspace(ws);
 }
 
 void monster_pathfind::set_range(int r)
@@ -79,7 +317,7 @@ void monster_pathfind::set_range(int r)
 
 coord_def monster_pathfind::next_pos(const coord_def &c) const
 {
-    return c + Compass[prev[c.x][c.y]];
+    return c + Compass[ws->prev(c)];
 }
 
 // The main method in the monster_pathfind class.
@@ -125,6 +363,157 @@ bool monster_pathfind::init_pathfind(coord_def src, coord_def dest, bool diag,
     return start_pathfind(msg);
 }
 
+// Whether mon's view of every trap on the level follows from the field key
+// alone. For hostile monsters, is_trap_safe() only turns to the monster's
+// position and health for the traps that fail its quick check.
+static bool _traps_settled(const monster &mon)
+{
+    for (const auto &entry : env.trap)
+        if (!mon.is_trap_safe(entry.first, true))
+            return false;
+    return true;
+}
+
+// Like init_pathfind(mon, dest), but hostile monsters of one kind heading
+// for the same cell in the same turn share a distance field rather than
+// each searching on their own. Needs a range.
+bool monster_pathfind::init_shared_pathfind(const monster* mon, coord_def dest)
+{
+    // Friendly summons keep to the player's sight, and these two see their
+    // companions as passable.
+    if (!range || mon->friendly() || mon->type == MONS_THORN_HUNTER
+        || mon->type == MONS_WANDERING_MUSHROOM || !_traps_settled(*mon))
+    {
+        return init_pathfind(mon, dest);
+    }
+
+    const pathfind_field_key key = { dest, range, mon->type,
+                                     mon->base_monster, mon->airborne(),
+                                     mon->attitude,
+                                     mon->berserk_or_insane() };
+    pathfind_field *field = _find_field(key);
+    if (!field)
+        return init_pathfind(mon, dest);
+
+    mons   = mon;
+    start  = mon->pos();
+    target = dest;
+    pos    = start;
+    allow_diagonals   = true;
+    traverse_unmapped = false;
+    traverse_in_sight = false;
+
+    if (start == target)
+        return true;
+
+    // The first monster to ask just searches.
+    if (!field->built)
+    {
+        if (!field->requests++)
+            return start_pathfind();
+
+        calc_field(field->dist);
+        field->built = true;
+    }
+
+    if (path_from_field(field->dist))
+        return true;
+
+    // The field's route can be blocked by something it didn't know about;
+    // search the usual way rather than report no path.
+    return field->dist[_field_cell(start)] != INFINITE_DISTANCE
+           && init_pathfind(mon, dest);
+}
+
+// Flood the cost of reaching the target outwards from it, over the same
+// cells (and within the same limits) a search would consider.
+void monster_pathfind::calc_field(int field[])
+{
+    ws->begin_search();
+    ws->set_dist(target, 0);
+    ws->push(target, 0);
+
+    const int max_dist = range * 2;
+    for (int d = 0; d <= max_dist; ++d)
+    {
+        while (!ws->bucket_empty(d))
+        {
+            const coord_def p = ws->pop(d);
+            const int cost = d + entry_cost(p);
+            if (cost > max_dist)
+                continue;
+
+            for (adjacent_iterator ai(p); ai; ++ai)
+            {
+                if (!in_bounds(*ai) || estimated_cost(*ai) > range)
+                    continue;
+
+                const int old_dist = ws->dist(*ai);
+                if (cost >= old_dist)
+                    continue;
+
+                ws->set_dist(*ai, cost);
+                // Monsters may start somewhere they couldn't pass through,
+                // so such cells get a distance, but nothing is reached by
+                // way of them.
+                if (!traversable(*ai))
+                    continue;
+
+                if (old_dist != INFINITE_DISTANCE)
+                    ws->remove(*ai, old_dist);
+                ws->push(*ai, cost);
+            }
+        }
+    }
+
+    for (rectangle_iterator ri(0); ri; ++ri)
+        field[_field_cell(*ri)] = ws->dist(*ri);
+}
+
+// Walk downhill through the field from start to target.
+bool monster_pathfind::path_from_field(const int field[])
+{
+    if (field[_field_cell(start)] == INFINITE_DISTANCE)
+        return false;
+
+    field_path.clear();
+    field_path.push_back(start);
+    pos = start;
+
+    // As with searching, ties are broken in a randomly rotated order.
+    const int rotate = random2(4) * 2;
+    while (pos != target)
+    {
+        const int here = field[_field_cell(pos)];
+        bool stepped = false;
+        for (int idir = 1; idir < 8; (idir += 2) == 9 && (idir = 0))
+        {
+            const coord_def npos = pos + Compass[(idir + rotate) % 8];
+            if (!in_bounds(npos)
+                || field[_field_cell(npos)] == INFINITE_DISTANCE
+                || (npos != target && !traversable(npos))
+                || field[_field_cell(npos)] + entry_cost(npos) != here)
+            {
+                continue;
+            }
+
+            pos = npos;
+            stepped = true;
+            break;
+        }
+
+        // Something now stands in the way; don't leave a broken path behind.
+        if (!stepped)
+        {
+            field_path.clear();
+            return false;
+        }
+        field_path.push_back(pos);
+    }
+
+    return true;
+}
+
 bool monster_pathfind::start_pathfind(bool msg)
 {
     // NOTE: We never do any traversable() check for the target square.
@@ -135,11 +524,8 @@ bool monster_pathfind::start_pathfind(bool msg)
     //       a wall.
 
     max_length = min_length = grid_distance(pos, target);
-    for (int i = 0; i < GXM; i++)
-        for (int j = 0; j < GYM; j++)
-            dist[i][j] = INFINITE_DISTANCE;
-
-    dist[pos.x][pos.y] = 0;
+    ws->begin_search();
+    ws->set_dist(pos, 0);
 
     bool success = false;
     do
@@ -209,8 +595,8 @@ bool monster_pathfind::calc_path_to_neighbours()
         if (range && estimated_cost(npos) > range)
             continue;
 
-        distance = dist[pos.x][pos.y] + travel_cost(npos);
-        old_dist = dist[npos.x][npos.y];
+        distance = ws->dist(pos) + travel_cost(npos);
+        old_dist = ws->dist(npos);
 
         // Also bail out if this would make the path longer than twice the
         // allowed distance from the target. (This factor may need tuning.)
@@ -252,7 +638,7 @@ bool monster_pathfind::calc_path_to_neighbours()
             }
 
             // Update distance start->pos.
-            dist[npos.x][npos.y] = distance;
+            ws->set_dist(npos, distance);
 
             // Set backtracking information.
             // Converts the Compass direction to its counterpart.
@@ -260,7 +646,7 @@ bool monster_pathfind::calc_path_to_neighbours()
             //      7  .  3   ==>   3  .  7       e.g. (3 + 4) % 8          = 7
             //      6  5  4         2  1  0            (7 + 4) % 8 = 11 % 8 = 3
 
-            prev[npos.x][npos.y] = (dir + 4) % 8;
+            ws->prev(npos) = (dir + 4) % 8;
 
             // Are we finished?
             if (npos == target)
@@ -276,22 +662,20 @@ bool monster_pathfind::calc_path_to_neighbours()
 }
 
 // Starting at known min_length (minimum total estimated path distance), check
-// the hash for existing vectors, then pick the last entry of the first vector
+// the hash for non-empty buckets, then pick the last entry of the first bucket
 // that matches. Update min_length, if necessary.
 bool monster_pathfind::get_best_position()
 {
     for (int i = min_length; i <= max_length; i++)
     {
-        if (!hash[i].empty())
+        if (!ws->bucket_empty(i))
         {
             if (i > min_length)
                 min_length = i;
 
-            vector<coord_def> &vec = hash[i];
-            // Pick the last position pushed into the vector as it's most
+            // Pick the last position pushed into the bucket as it's most
             // likely to be close to the target.
-            pos = vec[vec.size()-1];
-            vec.pop_back();
+            pos = ws->pop(i);
 
 #ifdef DEBUG_PATHFIND
             mprf("Returning (%d, %d) as best pos with total dist %d.",
@@ -316,6 +700,9 @@ vector<coord_def> monster_pathfind::backtrack()
 #ifdef DEBUG_PATHFIND
     mpr("Backtracking...");
 #endif
+    if (!field_path.empty())
+        return field_path;
+
     vector<coord_def> path;
     pos = target;
     path.push_back(pos);
@@ -326,7 +713,7 @@ vector<coord_def> monster_pathfind::backtrack()
     int dir;
     do
     {
-        dir = prev[pos.x][pos.y];
+        dir = ws->prev(pos);
         pos = pos + Compass[dir];
         ASSERT_IN_BOUNDS(pos);
 #ifdef DEBUG_PATHFIND
@@ -449,7 +836,12 @@ int monster_pathfind::travel_cost(coord_def npos)
 int monster_pathfind::mons_travel_cost(coord_def npos)
 {
     ASSERT(grid_distance(pos, npos) <= 1);
+    return entry_cost(npos);
+}
 
+// The cost for our monster of stepping onto npos from anywhere next to it.
+int monster_pathfind::entry_cost(coord_def npos)
+{
     // Doors need to be opened.
     if (feat_is_closed_door(env.grid(npos)))
         return 2;
@@ -491,24 +883,15 @@ int monster_pathfind::estimated_cost(coord_def p)
 
 void monster_pathfind::add_new_pos(coord_def npos, int total)
 {
-    hash[total].push_back(npos);
+    ws->push(npos, total);
 }
 
 void monster_pathfind::update_pos(coord_def npos, int total)
 {
     // Find hash position of old distance and delete it,
     // then call_add_new_pos.
-    int old_total = dist[npos.x][npos.y] + estimated_cost(npos);
-
-    vector<coord_def> &vec = hash[old_total];
-    for (unsigned int i = 0; i < vec.size(); i++)
-    {
-        if (vec[i] == npos)
-        {
-            vec.erase(vec.begin() + i);
-            break;
-        }
-    }
+    const int old_total = ws->dist(npos) + estimated_cost(npos);
+    ws->remove(npos, old_total);
 
     add_new_pos(npos, total);
 }
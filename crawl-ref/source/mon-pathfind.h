@@ -8,8 +8,10 @@
 using std::vector;
 
 class monster;
+class pathfind_workspace;
 
 int mons_tracking_range(const monster* mon);
+void invalidate_pathfind_fields();
 
 class monster_pathfind
 {
@@ -17,6 +19,8 @@ public:
     monster_pathfind();
     virtual ~monster_pathfind();
 
+    DISALLOW_COPY_AND_ASSIGN(monster_pathfind);
+
     // public methods
     void set_range(int r);
     coord_def next_pos(const coord_def &p) const;
@@ -25,6 +29,7 @@ public:
                        bool pass_unmapped = false);
     bool init_pathfind(coord_def src, coord_def dest,
                        bool diag = true, bool msg = false);
+    bool init_shared_pathfind(const monster* mon, coord_def dest);
     bool start_pathfind(bool msg = false);
     vector<coord_def> backtrack();
     vector<coord_def> calc_waypoints();
@@ -37,6 +42,9 @@ protected:
     bool mons_traversable(const coord_def& p);
     int  mons_travel_cost(coord_def npos);
     int  estimated_cost(coord_def npos);
+    int  entry_cost(coord_def npos);
+    void calc_field(int field[]);
+    bool path_from_field(const int field[]);
     void add_new_pos(coord_def pos, int total);
     void update_pos(coord_def pos, int total);
     bool get_best_position();
@@ -66,10 +74,10 @@ protected:
     int min_length;
     int max_length;
 
-    // The array of distances from start to any already tried point.
-    int dist[GXM][GYM];
-    // An array to store where we came from on a given shortest path.
-    int prev[GXM][GYM];
+    // Distances from start, backtracking information and the queue of
+    // positions to look at, borrowed from a pool for our lifetime.
+    pathfind_workspace *ws;
 
-    FixedVector<vector<coord_def>, GXM * GYM> hash;
+    // The path read from a shared distance field, if one was used.
+    vector<coord_def> field_path;
 };
@@ -35,6 +35,7 @@
 #include "mon-behv.h"
 #include "mon-death.h"
 #include "mon-gear.h"
+#include "mon-pathfind.h"
 #include "mon-pick.h"
 #include "mon-poly.h"
 #include "mon-tentacle.h"
@@ -854,6 +855,7 @@ monster* get_free_monster()
         if (mons.type == MONS_NO_MONSTER)
         {
             mons.reset();
+            mons_slot_used(mons);
             return &mons;
         }
 
@@ -1112,6 +1114,10 @@ static monster* _place_monster_aux(const mgen_data &mg, const monster *leader,
     if (mg.cls == MONS_SILENT_SPECTRE || mg.cls == MONS_PROFANE_SERVITOR)
         invalidate_agrid(true);
 
+    // A new stationary monster can block the shared pathfinding fields.
+    if (mon->is_stationary())
+        invalidate_pathfind_fields();
+
     // If the caller requested a specific colour for this monster, apply
     // it now.
     if ((mg.colour == COLOUR_INHERIT
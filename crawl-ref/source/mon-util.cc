@@ -5137,6 +5137,44 @@ void reset_all_monsters()
     }
 
     env.mid_cache.clear();
+    env.mons_used.clear();
+}
+
+// The env.mons index of mon, or -1 if it is a temporary or an anon slot.
+static int _used_slot_index(const monster &mon)
+{
+    if (&mon < &env.mons[0] || &mon >= &env.mons[MAX_MONSTERS])
+        return -1;
+    return &mon - &env.mons[0];
+}
+
+/**
+ * Record that an env.mons slot has been handed out, so that monster_iterator
+ * will visit it. Harmless for monsters outside env.mons, or already recorded.
+ */
+void mons_slot_used(const monster &mon)
+{
+    const int idx = _used_slot_index(mon);
+    if (idx < 0)
+        return;
+
+    auto &used = env.mons_used;
+    auto it = lower_bound(used.begin(), used.end(), idx);
+    if (it == used.end() || *it != idx)
+        used.insert(it, idx);
+}
+
+/// Forget an env.mons slot that has been reset.
+void mons_slot_freed(const monster &mon)
+{
+    const int idx = _used_slot_index(mon);
+    if (idx < 0)
+        return;
+
+    auto &used = env.mons_used;
+    auto it = lower_bound(used.begin(), used.end(), idx);
+    if (it != used.end() && *it == idx)
+        used.erase(it);
 }
 
 bool mons_is_recallable(const actor* caller, const monster& targ)
@@ -526,6 +526,8 @@ bool mons_is_player_shadow(const monster& mon);
 bool mons_has_attacks(const monster& mon);
 
 void reset_all_monsters();
+void mons_slot_used(const monster &mon);
+void mons_slot_freed(const monster &mon);
 void debug_mondata();
 void debug_monspells();
 
@@ -54,6 +54,7 @@
 #include "mon-poly.h"
 #include "mon-tentacle.h"
 #include "mon-transit.h"
+#include "mon-util.h"
 #include "religion.h"
 #include "spl-monench.h"
 #include "spl-summoning.h"
@@ -73,10 +74,10 @@
 
 monster::monster()
     : hit_points(0), max_hit_points(0),
-      speed(0), speed_increment(0), target(), firing_pos(),
+      speed(0), speed_increment(0), attitude(ATT_HOSTILE),
+      behaviour(BEH_WANDER), foe(MHITYOU), flags(), target(), firing_pos(),
       patrol_point(), travel_target(MTRAV_NONE), inv(NON_ITEM), spells(),
-      attitude(ATT_HOSTILE), behaviour(BEH_WANDER), foe(MHITYOU),
-      enchantments(), flags(), xp_tracking(XP_NON_VAULT), experience(0),
+      enchantments(), xp_tracking(XP_NON_VAULT), experience(0),
       base_monster(MONS_NO_MONSTER), number(0), colour(COLOUR_INHERIT),
       foe_memory(0), god(GOD_NO_GOD), ghost(), seen_context(SC_NONE),
       client_id(0), hit_dice(0)
@@ -146,6 +147,7 @@ void monster::reset()
     unseen_pos = coord_def(0, 0);
 
     mons_remove_from_grid(*this);
+    mons_slot_freed(*this);
     target.reset();
     position.reset();
     firing_pos.reset();
@@ -208,6 +210,9 @@ void monster::init_with(const monster& mon)
         ghost.reset(new ghost_demon(*mon.ghost));
     else
         ghost.reset(nullptr);
+
+    if (type != MONS_NO_MONSTER)
+        mons_slot_used(*this);
 }
 
 uint32_t monster::last_client_id = 0;
@@ -54,13 +54,20 @@ public:
     void reset();
 
 public:
-    // Possibly some of these should be moved into the hash table
-    string mname;
-
+    // The fields that the per-turn passes over every monster read come
+    // first, so that a pass touches as few cache lines of each monster as
+    // possible. Keep them together.
     int hit_points;
     int max_hit_points;
     int speed;
     int speed_increment;
+    mon_attitude_type attitude;
+    beh_type behaviour;
+    unsigned short foe;
+    monster_flags_t flags;             // bitfield of boolean flags
+
+    // Possibly some of these should be moved into the hash table
+    string mname;
 
     coord_def target;
     coord_def firing_pos;
@@ -69,13 +76,9 @@ public:
     vector<coord_def> travel_path;
     FixedVector<short, NUM_MONSTER_SLOTS> inv;
     monster_spells spells;
-    mon_attitude_type attitude;
-    beh_type behaviour;
-    unsigned short foe;
     int8_t ench_countdown;
     mon_enchant_list enchantments;
     FixedBitVector<NUM_ENCHANTMENTS> ench_cache;
-    monster_flags_t flags;             // bitfield of boolean flags
     xp_tracking_type xp_tracking;
 
     unsigned int experience;
@@ -436,6 +436,8 @@ public:
                                     // a name set on game start
     bool        read_persist_options; // If true, Crawl will try to load
                                       // options from c_persist.options
+    int         db_cache_size;  // Number of text database entries to keep
+                                // in memory
 
     vector<text_pattern> drop_filter;
 
@@ -1490,6 +1490,7 @@ void redraw_screen(bool show_updates)
 
     draw_border();
 
+    view_redraw_all();
     you.redraw_stats.init(true);
     you.redraw_title         = true;
     you.redraw_hit_points    = true;
@@ -38,6 +38,7 @@ Notes:
 #include "errors.h"
 #include "syscalls.h"
 #include "libutil.h" // map_find
+#include "threads.h"
 
 // debugging defines
 #undef  FSCK_VERBOSE
@@ -59,9 +60,26 @@ static plen_t htole(plen_t x)
 #define dprintf(...) do {} while (0)
 #endif
 
-#define PACKAGE_VERSION 1
 #define PACKAGE_MAGIC   0x53534344 /* "DCSS" */
 
+// How many chunks may be compressing in the background at once.
+#define PACKAGE_WORKERS 4
+
+// Whether readers decompress straight from a mapping of the file, rather
+// than reading it block by block.
+#if defined(UNIX) && !defined(__ANDROID__)
+# define PACKAGE_USE_MMAP true
+#else
+# define PACKAGE_USE_MMAP false
+#endif
+
+#ifdef USE_ZSTD
+# define PACKAGE_DEFAULT_CODEC chunk_codec::zstd
+# define ZSTD_LEVEL 3
+#else
+# define PACKAGE_DEFAULT_CODEC chunk_codec::zlib
+#endif
+
 struct file_header
 {
     uint32_t magic;
@@ -81,11 +99,74 @@ typedef pair<plen_t, plen_t> bm_p;
 typedef map<plen_t, bm_p> bm_t;
 typedef map<plen_t, plen_t> fb_t;
 
+// A closed chunk waiting to be compressed and written out.
+struct pending_chunk
+{
+    string name;
+    chunk_codec codec;
+    vector<unsigned char> data;  // uncompressed, then compressed
+    string error;                // set by a failed compression
+    thread_t thread;
+    bool running;                // a worker thread still needs joining
+};
+
+// Compress job->data in place. This may run on a worker thread, so it
+// must not touch the package, and reports errors in job->error rather
+// than through fail().
+static void *_compress_chunk(void *arg)
+{
+    pending_chunk *job = static_cast<pending_chunk *>(arg);
+    vector<unsigned char> out;
+
+    switch (job->codec)
+    {
+#ifdef USE_ZLIB
+    case chunk_codec::zlib:
+    {
+        uLongf len = compressBound(job->data.size());
+        out.resize(len);
+        int res = compress2(out.data(), &len, job->data.data(),
+                            job->data.size(), Z_DEFAULT_COMPRESSION);
+        if (res != Z_OK)
+            job->error = zError(res);
+        out.resize(len);
+        break;
+    }
+#endif
+#ifdef USE_ZSTD
+    case chunk_codec::zstd:
+    {
+        out.resize(ZSTD_compressBound(job->data.size()));
+        size_t len = ZSTD_compress(out.data(), out.size(), job->data.data(),
+                                   job->data.size(), ZSTD_LEVEL);
+        if (ZSTD_isError(len))
+            job->error = ZSTD_getErrorName(len);
+        else
+            out.resize(len);
+        break;
+    }
+#endif
+#ifndef USE_ZLIB
+    case chunk_codec::zlib:
+        // Stored as-is.
+        return nullptr;
+#endif
+    default:
+        job->error = "unsupported codec";
+        break;
+    }
+
+    job->data.swap(out);
+    return nullptr;
+}
+
 package::package(const char* file, bool writeable, bool empty)
   : n_users(0), dirty(false), aborted(false)
 #ifdef DO_FSYNC
     , tmp(false)
 #endif
+    , codec(PACKAGE_DEFAULT_CODEC), dir_version(1),
+    use_mmap(PACKAGE_USE_MMAP)
 {
     dprintf("package: initializing file=\"%s\" rw=%d\n", file, writeable);
     ASSERT(writeable || !empty);
@@ -136,6 +217,8 @@ package::package()
 #ifdef DO_FSYNC
     , tmp(true)
 #endif
+    , codec(PACKAGE_DEFAULT_CODEC), dir_version(1),
+    use_mmap(PACKAGE_USE_MMAP)
 {
     dprintf("package: initializing tmp file\n");
     filename = "[tmp]";
@@ -220,6 +303,7 @@ package::~package()
         if (ftruncate(fd, file_len))
             sysfail("failed to update save file");
     }
+    drop_chunks();
 
     // all errors here should be cached write errors
     if (fd != -1)
@@ -234,6 +318,7 @@ package::~package()
 void package::commit()
 {
     ASSERT(rw);
+    flush_chunks();
     if (!dirty)
         return;
     ASSERT(!aborted);
@@ -244,9 +329,9 @@ void package::commit()
 
     file_header head;
     head.magic = htole(PACKAGE_MAGIC);
-    head.version = PACKAGE_VERSION;
-    memset(&head.padding, 0, sizeof(head.padding));
     head.start = htole(write_directory());
+    head.version = dir_version;
+    memset(&head.padding, 0, sizeof(head.padding));
 #ifdef DO_FSYNC
     // We need a barrier before updating the link to point at the new directory.
     if (!tmp && fdatasync(fd))
@@ -279,6 +364,36 @@ void package::seek(plen_t to)
         sysfail("failed to seek inside the save file");
 }
 
+void package::set_mmap(bool m)
+{
+    use_mmap = m;
+    if (!m)
+        mapping.reset();
+}
+
+// Map the whole file, or reuse the current mapping if it still covers it.
+// Writes go through the same page cache, so an older mapping stays correct
+// for the part it covers; readers keep theirs alive if it gets replaced.
+shared_ptr<mapped_file> package::map_file()
+{
+    if (!use_mmap || fd == -1)
+        return nullptr;
+
+    if (!mapping || mapping->size() < file_len)
+    {
+        mapping.reset(new mapped_file(fd, file_len));
+        if (!mapping->valid())
+        {
+            // Don't bother trying again.
+            dprintf("package: can't map %s, reading it instead\n",
+                    filename.c_str());
+            mapping.reset();
+            use_mmap = false;
+        }
+    }
+    return mapping;
+}
+
 chunk_writer* package::writer(const string &name)
 {
     return new chunk_writer(this, name);
@@ -286,8 +401,8 @@ chunk_writer* package::writer(const string &name)
 
 chunk_reader* package::reader(const string &name)
 {
-    if (plen_t *ch = map_find(directory, name))
-        return new chunk_reader(this, *ch);
+    if (has_chunk(name))
+        return new chunk_reader(this, name);
     return 0;
 }
 
@@ -359,6 +474,138 @@ plen_t package::alloc_block(plen_t &size)
     return at;
 }
 
+void package::queue_chunk(const string &name, vector<unsigned char> &data)
+{
+    pending_chunk *job = new pending_chunk;
+    job->name = name;
+    // The directory is always zlib, so older versions can find out that
+    // they can't read the rest.
+    job->codec = name.empty() ? chunk_codec::zlib : codec;
+    job->data.swap(data);
+    job->running = false;
+    pending.push_back(job);
+
+    // Keep the pool bounded by waiting for the oldest compression.
+    int running = 0;
+    for (pending_chunk *other : pending)
+        running += other->running;
+    for (pending_chunk *other : pending)
+    {
+        if (running < PACKAGE_WORKERS)
+            break;
+        if (other->running)
+        {
+            thread_join(other->thread);
+            other->running = false;
+            running--;
+        }
+    }
+
+    if (!name.empty()
+        && !thread_create_joinable(&job->thread, _compress_chunk, job))
+    {
+        job->running = true;
+    }
+    else
+        _compress_chunk(job);
+}
+
+// Wait for all pending compressions, and write the chunks out in the
+// order they were closed.
+void package::flush_chunks()
+{
+    if (pending.empty())
+        return;
+
+    for (pending_chunk *job : pending)
+    {
+        if (job->running)
+            thread_join(job->thread);
+        job->running = false;
+    }
+
+    vector<pending_chunk*> jobs;
+    jobs.swap(pending);
+    string error;
+    for (pending_chunk *job : jobs)
+    {
+        if (error.empty() && !aborted)
+        {
+            if (job->error.empty())
+            {
+                finish_chunk(job->name, write_block_chain(job->data));
+                chunk_codecs[job->name] = job->codec;
+            }
+            else
+                error = job->error;
+        }
+        delete job;
+    }
+
+    if (!error.empty())
+        fail("save file compression failed: %s", error.c_str());
+}
+
+// Forget all pending chunks, after an abort.
+void package::drop_chunks()
+{
+    for (pending_chunk *job : pending)
+    {
+        if (job->running)
+            thread_join(job->thread);
+        delete job;
+    }
+    pending.clear();
+}
+
+// Write data to a fresh chain of blocks, returning the first.
+plen_t package::write_block_chain(const vector<unsigned char> &data)
+{
+    plen_t first_block = 0, cur_block = 0, block_len = 0;
+    const unsigned char *buf = data.data();
+    plen_t len = data.size();
+
+    while (len > 0)
+    {
+        plen_t space = extend_block(cur_block, block_len, len);
+        if (!space)
+        {
+            plen_t next_block = alloc_block(space = len);
+            ASSERT(space > 0);
+            if (cur_block)
+                finish_block(cur_block, block_len, next_block);
+            cur_block = next_block;
+            if (!first_block)
+                first_block = next_block;
+            block_len = 0;
+        }
+
+        seek(cur_block + block_len + sizeof(block_header));
+        if (::write(fd, buf, space) != (ssize_t)space)
+            sysfail("write error while saving");
+        buf += space;
+        block_len += space;
+        len -= space;
+    }
+    if (cur_block)
+        finish_block(cur_block, block_len, 0);
+
+    return first_block;
+}
+
+void package::finish_block(plen_t at, plen_t len, plen_t next)
+{
+    block_header head;
+    head.len = htole(len);
+    head.next = htole(next);
+
+    seek(at);
+    if (::write(fd, &head, sizeof(head)) != sizeof(head))
+        sysfail("write error while saving");
+
+    block_map[at] = bm_p(len, next);
+}
+
 void package::finish_chunk(const string &name, plen_t at)
 {
     free_chunk(name);
@@ -384,20 +631,36 @@ void package::free_chunk(const string &name)
 
 void package::delete_chunk(const string &name)
 {
+    flush_chunks();
     free_chunk(name);
     directory.erase(name);
+    chunk_codecs.erase(name);
 }
 
 plen_t package::write_directory()
 {
     delete_chunk("");
 
+    // Version 2 adds a codec to every directory entry. It's only written
+    // when some chunk isn't zlib, so that zlib-only saves stay readable by
+    // older versions.
+    dir_version = 1;
+    for (const auto &entry : chunk_codecs)
+        if (entry.second != chunk_codec::zlib)
+            dir_version = 2;
+
     stringstream dir;
     for (const auto &entry : directory)
     {
         uint8_t name_len = entry.first.length();
         dir.write((const char*)&name_len, sizeof(name_len));
         dir.write(&entry.first[0], entry.first.length());
+        if (dir_version >= 2)
+        {
+            const chunk_codec *c = map_find(chunk_codecs, entry.first);
+            uint8_t ch_codec = static_cast<uint8_t>(c ? *c : chunk_codec::zlib);
+            dir.write((const char*)&ch_codec, sizeof(ch_codec));
+        }
         plen_t start = htole(entry.second);
         dir.write((const char*)&start, sizeof(plen_t));
     }
@@ -408,6 +671,7 @@ plen_t package::write_directory()
         chunk_writer dch(this, "");
         dch.write(&dir.str()[0], dir.str().size());
     }
+    flush_chunks();
 
     return directory[""];
 }
@@ -540,7 +804,9 @@ void package::read_directory(plen_t start, uint8_t version)
         }
         break;
     case 1:
+    case 2:
         uint8_t name_len;
+        uint8_t ch_codec;
         plen_t bstart;
         while (plen_t res = rd.read(&name_len, sizeof(name_len)))
         {
@@ -550,6 +816,17 @@ void package::read_directory(plen_t start, uint8_t version)
             chname.resize(name_len);
             if (rd.read(&chname[0], name_len) != name_len)
                 corrupted("save file corrupted -- truncated directory");
+            if (version >= 2)
+            {
+                if (rd.read(&ch_codec, sizeof(ch_codec)) != sizeof(ch_codec))
+                    corrupted("save file corrupted -- truncated directory");
+                if (ch_codec > static_cast<uint8_t>(chunk_codec::zstd))
+                {
+                    corrupted("save file (%s) uses an unknown codec %u",
+                              filename.c_str(), ch_codec);
+                }
+                chunk_codecs[chname] = static_cast<chunk_codec>(ch_codec);
+            }
             if (rd.read(&bstart, sizeof(bstart)) != sizeof(bstart))
                 corrupted("save file corrupted -- truncated directory");
             directory[chname] = htole(bstart);
@@ -564,11 +841,13 @@ void package::read_directory(plen_t start, uint8_t version)
 
 bool package::has_chunk(const string &name)
 {
+    flush_chunks();
     return !name.empty() && directory.count(name);
 }
 
 vector<string> package::list_chunks()
 {
+    flush_chunks();
     vector<string> list;
     list.reserve(directory.size());
     for (const auto &entry : directory)
@@ -620,6 +899,7 @@ void package::abort()
     // this point are ignored (assuming we already failed). All writes since
     // the last commit() are lost.
     aborted = true;
+    drop_chunks();
 }
 
 void package::unlink()
@@ -633,6 +913,7 @@ void package::unlink()
 // the amount of free space not at the end of file
 plen_t package::get_slack()
 {
+    flush_chunks();
     load_traces();
 
     plen_t slack = 0;
@@ -643,6 +924,7 @@ plen_t package::get_slack()
 
 plen_t package::get_chunk_fragmentation(const string &name)
 {
+    flush_chunks();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t frags = 0;
@@ -659,6 +941,7 @@ plen_t package::get_chunk_fragmentation(const string &name)
 
 plen_t package::get_chunk_compressed_length(const string &name)
 {
+    flush_chunks();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t len = 0;
@@ -674,7 +957,6 @@ plen_t package::get_chunk_compressed_length(const string &name)
 }
 
 chunk_writer::chunk_writer(package *parent, const string &_name)
-    : first_block(0), cur_block(0), block_len(0)
 {
     ASSERT(parent);
     ASSERT(!parent->aborted);
@@ -687,18 +969,6 @@ chunk_writer::chunk_writer(package *parent, const string &_name)
     pkg = parent;
     pkg->n_users++;
     name = _name;
-
-#ifdef USE_ZLIB
-    zs.data_type = Z_BINARY;
-    zs.zalloc    = 0;
-    zs.zfree     = 0;
-    zs.opaque    = Z_NULL;
-    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION))
-        fail("save file compression failed during init: %s", zs.msg);
-#define ZB_SIZE 32768
-    zs.next_out  = z_buffer = (Bytef*)malloc(ZB_SIZE);
-    zs.avail_out = ZB_SIZE;
-#endif
 }
 
 chunk_writer::~chunk_writer()
@@ -708,121 +978,64 @@ chunk_writer::~chunk_writer()
     ASSERT(pkg->n_users > 0);
     pkg->n_users--;
     if (pkg->aborted)
-    {
-#ifdef USE_ZLIB
-        // ignore errors, they're not relevant anymore
-        deflateEnd(&zs);
-        free(z_buffer);
-#endif
         return;
-    }
-
-#ifdef USE_ZLIB
-    zs.avail_in = 0;
-    int res;
-    do
-    {
-        res = deflate(&zs, Z_FINISH);
-        if (res != Z_STREAM_END && res != Z_OK && res != Z_BUF_ERROR)
-            fail("save file compression failed: %s", zs.msg);
-        raw_write(z_buffer, zs.next_out - z_buffer);
-        zs.next_out = z_buffer;
-        zs.avail_out = ZB_SIZE;
-    } while (res != Z_STREAM_END);
-    if (deflateEnd(&zs) != Z_OK)
-        fail("save file compression failed during clean-up: %s", zs.msg);
-    free(z_buffer);
-#endif
-    if (cur_block)
-        finish_block(0);
-    pkg->finish_chunk(name, first_block);
-}
-
-void chunk_writer::raw_write(const void *data, plen_t len)
-{
-    while (len > 0)
-    {
-        plen_t space = pkg->extend_block(cur_block, block_len, len);
-        if (!space)
-        {
-            plen_t next_block = pkg->alloc_block(space = len);
-            ASSERT(space > 0);
-            if (cur_block)
-                finish_block(next_block);
-            cur_block = next_block;
-            if (!first_block)
-                first_block = next_block;
-            block_len = 0;
-        }
-
-        pkg->seek(cur_block + block_len + sizeof(block_header));
-        if (::write(pkg->fd, data, space) != (ssize_t)space)
-            sysfail("write error while saving");
-        data = (char*)data + space;
-        block_len += space;
-        len -= space;
-    }
-}
-
-void chunk_writer::finish_block(plen_t next)
-{
-    block_header head;
-    head.len = htole(block_len);
-    head.next = htole(next);
 
-    pkg->seek(cur_block);
-    if (::write(pkg->fd, &head, sizeof(head)) != sizeof(head))
-        sysfail("write error while saving");
-
-    pkg->block_map[cur_block] = bm_p(block_len, next);
+    pkg->queue_chunk(name, data);
 }
 
-void chunk_writer::write(const void *data, plen_t len)
+void chunk_writer::write(const void *_data, plen_t len)
 {
-    ASSERT(data);
+    ASSERT(_data);
     ASSERT(!pkg->aborted);
 
-#ifdef USE_ZLIB
-    zs.next_in  = (Bytef*)data;
-    zs.avail_in = len;
-    while (zs.avail_in)
-    {
-        if (!zs.avail_out)
-        {
-            raw_write(z_buffer, zs.next_out - z_buffer);
-            zs.next_out  = z_buffer;
-            zs.avail_out = ZB_SIZE;
-        }
-        // we don't allow Z_BUF_ERROR, so it's fatal for us
-        if (deflate(&zs, Z_NO_FLUSH) != Z_OK)
-            fail("save file compression failed: %s", zs.msg);
-    }
-#else
-    raw_write(data, len);
-#endif
+    const unsigned char *bytes = static_cast<const unsigned char *>(_data);
+    data.insert(data.end(), bytes, bytes + len);
 }
 
-void chunk_reader::init(plen_t start)
+void chunk_reader::init(plen_t start, chunk_codec _codec)
 {
     ASSERT(!pkg->aborted);
     pkg->n_users++;
     pkg->reader_count[start]++;
     first_block = next_block = start;
     block_left = 0;
+    codec = _codec;
+    mapping = pkg->map_file();
 
-#ifdef USE_ZLIB
-    if (!start)
-        corrupted("save file corrupted -- zlib header missing");
-
-    zs.zalloc    = 0;
-    zs.zfree     = 0;
-    zs.opaque    = Z_NULL;
-    zs.next_in   = Z_NULL;
-    zs.avail_in  = 0;
-    if (inflateInit(&zs))
-        fail("save file decompression failed during init: %s", zs.msg);
     eof = false;
+    switch (codec)
+    {
+    case chunk_codec::zlib:
+#ifdef USE_ZLIB
+        if (!start)
+            corrupted("save file corrupted -- zlib header missing");
+
+        zs.zalloc    = 0;
+        zs.zfree     = 0;
+        zs.opaque    = Z_NULL;
+        zs.next_in   = Z_NULL;
+        zs.avail_in  = 0;
+        if (inflateInit(&zs))
+            fail("save file decompression failed during init: %s", zs.msg);
+#endif
+        break;
+    case chunk_codec::zstd:
+#ifdef USE_ZSTD
+        if (!start)
+            corrupted("save file corrupted -- zstd header missing");
+
+        zds = ZSTD_createDStream();
+        if (!zds)
+            fail("save file decompression failed during init");
+        ZSTD_initDStream(zds);
+        zin.src  = z_buffer;
+        zin.size = 0;
+        zin.pos  = 0;
+#else
+        fail("this save file needs zstd, which this build lacks");
 #endif
+        break;
+    }
 }
 
 chunk_reader::chunk_reader(package *parent, plen_t start)
@@ -830,7 +1043,8 @@ chunk_reader::chunk_reader(package *parent, plen_t start)
     ASSERT(parent);
     dprintf("chunk_reader[%u]: starting\n", start);
     pkg = parent;
-    init(start);
+    // Only the directory is read this way, and it's always zlib.
+    init(start, chunk_codec::zlib);
 }
 
 chunk_reader::chunk_reader(package *parent, const string &_name)
@@ -840,7 +1054,8 @@ chunk_reader::chunk_reader(package *parent, const string &_name)
         corrupted("save file corrupted -- chunk \"%s\" missing", _name.c_str());
     dprintf("chunk_reader(%s): starting\n", _name.c_str());
     pkg = parent;
-    init(parent->directory[_name]);
+    const chunk_codec *c = map_find(parent->chunk_codecs, _name);
+    init(parent->directory[_name], c ? *c : chunk_codec::zlib);
 }
 
 chunk_reader::~chunk_reader()
@@ -848,8 +1063,12 @@ chunk_reader::~chunk_reader()
     dprintf("chunk_reader: closing\n");
 
 #ifdef USE_ZLIB
-    if (inflateEnd(&zs) != Z_OK)
+    if (codec == chunk_codec::zlib && inflateEnd(&zs) != Z_OK)
         fail("save file decompression failed during clean-up: %s", zs.msg);
+#endif
+#ifdef USE_ZSTD
+    if (codec == chunk_codec::zstd)
+        ZSTD_freeDStream(zds);
 #endif
     ASSERT(pkg->reader_count[first_block] > 0);
     if (!--pkg->reader_count[first_block])
@@ -858,6 +1077,35 @@ chunk_reader::~chunk_reader()
     pkg->n_users--;
 }
 
+void chunk_reader::next_block_header()
+{
+    block_header bl;
+    if (mapping)
+    {
+        if ((size_t)next_block + sizeof(block_header) > mapping->size())
+            corrupted("save file corrupted -- block past eof");
+        memcpy(&bl, mapping->data() + next_block, sizeof(block_header));
+    }
+    else
+    {
+        pkg->seek(next_block);
+        ssize_t res = ::read(pkg->fd, &bl, sizeof(block_header));
+        if (res < 0)
+            sysfail("error reading the save file");
+        if (res != sizeof(block_header))
+            corrupted("save file corrupted -- block past eof");
+    }
+
+    off = next_block + sizeof(block_header);
+    block_left = htole(bl.len);
+    next_block = htole(bl.next);
+    // This reeks of on-disk corruption (zeroed data).
+    if (!block_left)
+        corrupted("save file corrupted -- empty block");
+    if (mapping && (size_t)off + block_left > mapping->size())
+        corrupted("save file corrupted -- block past eof");
+}
+
 plen_t chunk_reader::raw_read(void *data, plen_t len)
 {
     void *buf = data;
@@ -867,33 +1115,24 @@ plen_t chunk_reader::raw_read(void *data, plen_t len)
         {
             if (!next_block)
                 return (char*)buf - (char*)data;
-
-            block_header bl;
-            pkg->seek(next_block);
-            ssize_t res = ::read(pkg->fd, &bl, sizeof(block_header));
-            if (res < 0)
-                sysfail("error reading the save file");
-            if (res != sizeof(block_header))
-                corrupted("save file corrupted -- block past eof");
-
-            off = next_block + sizeof(block_header);
-            block_left = htole(bl.len);
-            next_block = htole(bl.next);
-            // This reeks of on-disk corruption (zeroed data).
-            if (!block_left)
-                corrupted("save file corrupted -- empty block");
+            next_block_header();
         }
-        else
+        else if (!mapping)
             pkg->seek(off);
 
         plen_t s = len;
         if (s > block_left)
             s = block_left;
-        ssize_t res = ::read(pkg->fd, buf, s);
-        if (res < 0)
-            sysfail("error reading the save file");
-        if ((plen_t)res != s)
-            corrupted("save file corrupted -- block past eof");
+        if (mapping)
+            memcpy(buf, mapping->data() + off, s);
+        else
+        {
+            ssize_t res = ::read(pkg->fd, buf, s);
+            if (res < 0)
+                sysfail("error reading the save file");
+            if ((plen_t)res != s)
+                corrupted("save file corrupted -- block past eof");
+        }
 
         buf = (char*)buf + s;
         off += s;
@@ -904,12 +1143,79 @@ plen_t chunk_reader::raw_read(void *data, plen_t len)
     return (char*)buf - (char*)data;
 }
 
+// Point data at the rest of the current block in the mapped file, and
+// return its length (0 at the end of the chunk).
+plen_t chunk_reader::map_read(const unsigned char *&data)
+{
+    ASSERT(mapping);
+    if (!block_left)
+    {
+        if (!next_block)
+            return 0;
+        next_block_header();
+    }
+
+    data = mapping->data() + off;
+    plen_t len = block_left;
+    off += len;
+    block_left = 0;
+    return len;
+}
+
 plen_t chunk_reader::read(void *data, plen_t len)
 {
     ASSERT(data);
     if (pkg->aborted)
         return 0;
 
+#ifdef USE_ZSTD
+    if (codec == chunk_codec::zstd)
+    {
+        if (!len || eof)
+            return 0;
+
+        ZSTD_outBuffer zout = { data, len, 0 };
+        while (zout.pos < zout.size)
+        {
+            // No content checksum is written, so the decoder can have taken
+            // all of the input while it still holds output. Only go for
+            // more input once a call makes no progress without it.
+            const size_t in_pos = zin.pos, out_pos = zout.pos;
+            size_t res = ZSTD_decompressStream(zds, &zout, &zin);
+            if (ZSTD_isError(res))
+            {
+                corrupted("save file decompression failed: %s",
+                          ZSTD_getErrorName(res));
+            }
+            if (!res)
+            {
+                eof = true;
+                break;
+            }
+            if (zin.pos != in_pos || zout.pos != out_pos)
+                continue;
+            if (zin.pos < zin.size)
+                corrupted("save file decompression failed: no progress");
+
+            if (mapping)
+            {
+                const unsigned char *in;
+                zin.size = map_read(in);
+                zin.src  = in;
+            }
+            else
+            {
+                zin.size = raw_read(z_buffer, sizeof(z_buffer));
+                zin.src  = z_buffer;
+            }
+            zin.pos  = 0;
+            if (!zin.size)
+                corrupted("save file corrupted -- block truncated");
+        }
+        return zout.pos;
+    }
+#endif
+
 #ifdef USE_ZLIB
     if (!len)
         return 0;
@@ -922,8 +1228,17 @@ plen_t chunk_reader::read(void *data, plen_t len)
     {
         if (!zs.avail_in)
         {
-            zs.next_in  = z_buffer;
-            zs.avail_in = raw_read(z_buffer, sizeof(z_buffer));
+            if (mapping)
+            {
+                const unsigned char *in;
+                zs.avail_in = map_read(in);
+                zs.next_in  = const_cast<Bytef*>(in);
+            }
+            else
+            {
+                zs.next_in  = z_buffer;
+                zs.avail_in = raw_read(z_buffer, sizeof(z_buffer));
+            }
             if (!zs.avail_in)
                 corrupted("save file corrupted -- block truncated");
         }
@@ -3,16 +3,21 @@
 #define USE_ZLIB
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 #ifdef USE_ZLIB
 #include <zlib.h>
 #endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 using std::map;
 using std::pair;
 using std::set;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
@@ -24,22 +29,27 @@ using std::vector;
 
 typedef uint32_t plen_t;
 
+// How a chunk's contents are compressed. Packages before version 2 don't
+// record this, and use zlib throughout.
+enum class chunk_codec : uint8_t
+{
+    zlib,
+    zstd,
+};
+
+class mapped_file;
 class package;
+struct pending_chunk;
 
+// Chunk contents are collected in memory, and compressed (possibly on
+// another thread) once the writer is closed. The package writes them out
+// in order before anything else looks at them.
 class chunk_writer
 {
 private:
     package *pkg;
     string name;
-    plen_t first_block;
-    plen_t cur_block;
-    plen_t block_len;
-#ifdef USE_ZLIB
-    z_stream zs;
-    Bytef *z_buffer;
-#endif
-    void raw_write(const void *data, plen_t len);
-    void finish_block(plen_t next);
+    vector<unsigned char> data;
 public:
     chunk_writer(package *parent, const string &_name);
     ~chunk_writer();
@@ -51,16 +61,25 @@ class chunk_reader
 {
 private:
     chunk_reader(package *parent, plen_t start);
-    void init(plen_t start);
+    void init(plen_t start, chunk_codec _codec);
     package *pkg;
     plen_t first_block, next_block;
     plen_t off, block_left;
-#ifdef USE_ZLIB
+    chunk_codec codec;
+    // When set, compressed data is taken straight from the mapped file.
+    shared_ptr<mapped_file> mapping;
     bool eof;
+    unsigned char z_buffer[32768];
+#ifdef USE_ZLIB
     z_stream zs;
-    Bytef z_buffer[32768];
+#endif
+#ifdef USE_ZSTD
+    ZSTD_DStream *zds;
+    ZSTD_inBuffer zin;
 #endif
     plen_t raw_read(void *data, plen_t len);
+    plen_t map_read(const unsigned char *&data);
+    void next_block_header();
 public:
     chunk_reader(package *parent, const string &_name);
     ~chunk_reader();
@@ -84,6 +103,14 @@ public:
     void abort();
     void unlink();
 
+    // Codec for chunks written from now on.
+    void set_codec(chunk_codec c) { codec = c; }
+    // Whether readers may decompress from a mapping of the file.
+    void set_mmap(bool m);
+    // False once mapping the file has failed, and readers went back to
+    // reading it block by block.
+    bool uses_mmap() const { return use_mmap; }
+
     // statistics
     plen_t get_slack();
     plen_t get_size() const { return file_len; };
@@ -100,7 +127,13 @@ private:
 #ifdef DO_FSYNC
     bool tmp;
 #endif
+    chunk_codec codec;
+    uint8_t dir_version;
     map<string, plen_t> directory;
+    map<string, chunk_codec> chunk_codecs;
+    vector<pending_chunk*> pending;
+    bool use_mmap;
+    shared_ptr<mapped_file> mapping;
     map<plen_t, plen_t> free_blocks;
     vector<plen_t> unlinked_blocks;
     map<plen_t, pair<plen_t, plen_t> > block_map;
@@ -108,6 +141,11 @@ private:
     map<plen_t, uint32_t> reader_count;
     plen_t extend_block(plen_t at, plen_t size, plen_t by);
     plen_t alloc_block(plen_t &size);
+    void queue_chunk(const string &name, vector<unsigned char> &data);
+    void flush_chunks();
+    void drop_chunks();
+    plen_t write_block_chain(const vector<unsigned char> &data);
+    void finish_block(plen_t at, plen_t len, plen_t next);
     void finish_chunk(const string &name, plen_t at);
     void free_chunk(const string &name);
     plen_t write_directory();
@@ -117,6 +155,7 @@ private:
     void seek(plen_t to);
     void fsck();
     void read_directory(plen_t start, uint8_t version);
+    shared_ptr<mapped_file> map_file();
     void trace_chunk(plen_t start);
     void load();
     void load_traces();
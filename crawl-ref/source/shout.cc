@@ -865,6 +865,87 @@ static int _noise_attenuation_millis(const coord_def &pos)
                                           1);
 }
 
+// Noise travels outwards from its sources in rounds, one square further each
+// round. Each round's squares are kept as flat indices, x * GYM + y, in
+// buffers that live across calls, so a noisy turn doesn't allocate. What a
+// square does to noise only depends on the terrain and silence, which can't
+// change while noise spreads, so that's worked out the first time the noise
+// reaches a square and kept until the next propagation.
+static const int _noise_neighbour_offsets[8] =
+{
+    -GYM - 1, -GYM, -GYM + 1, -1, 1, GYM - 1, GYM, GYM + 1,
+};
+
+static const coord_def _noise_neighbour_deltas[8] =
+{
+    { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 },
+    { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 },
+};
+
+class noise_wavefront
+{
+public:
+    noise_wavefront() : generation(0)
+    {
+        perimeter[0].reserve(GXM * GYM);
+        perimeter[1].reserve(GXM * GYM);
+    }
+
+    void start()
+    {
+        if (!++generation)
+        {
+            for (noise_square &sq : squares)
+                sq.generation = 0;
+            generation = 1;
+        }
+        perimeter[0].clear();
+        perimeter[1].clear();
+    }
+
+    // How much noise loses on leaving the square.
+    int attenuation(int index)
+    {
+        return square(index).attenuation;
+    }
+
+    // Whether noise can't get into the square at all.
+    bool blocked(int index)
+    {
+        return square(index).blocked;
+    }
+
+    vector<int> perimeter[2];
+
+private:
+    struct noise_square
+    {
+        unsigned int generation = 0;
+        int attenuation = 0;
+        bool blocked = false;
+    };
+
+    noise_square &square(int index)
+    {
+        noise_square &sq(squares[index]);
+        if (sq.generation != generation)
+        {
+            const coord_def c(index / GYM, index % GYM);
+            sq.generation = generation;
+            sq.attenuation = _noise_attenuation_millis(c);
+            sq.blocked = !in_bounds(c) || silenced(c);
+        }
+        return sq;
+    }
+
+    noise_square squares[GXM * GYM];
+    unsigned int generation;
+};
+
+// Only ever used by propagate_noise(), which apply_noises() runs on a copy
+// of the grid, so noise made while it's applying effects can't get in.
+static noise_wavefront _noise_wavefront;
+
 noise_cell::noise_cell()
     : neighbour_delta(0, 0), noise_id(-1), noise_intensity_millis(0),
       noise_travel_distance(0)
@@ -945,62 +1026,54 @@ void noise_grid::propagate_noise()
     dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
          (unsigned int)noises.size());
 #endif
-    vector<coord_def> noise_perimeter[2];
+    noise_wavefront &wave(_noise_wavefront);
+    wave.start();
     int circ_index = 0;
 
     for (const noise_t &noise : noises)
-        noise_perimeter[circ_index].push_back(noise.noise_source);
+    {
+        wave.perimeter[circ_index].push_back(noise.noise_source.x * GYM
+                                             + noise.noise_source.y);
+    }
 
     int travel_distance = 0;
-    while (!noise_perimeter[circ_index].empty())
+    while (!wave.perimeter[circ_index].empty())
     {
-        const vector<coord_def> &perimeter(noise_perimeter[circ_index]);
-        vector<coord_def> &next_perimeter(noise_perimeter[!circ_index]);
+        const vector<int> &perimeter(wave.perimeter[circ_index]);
+        vector<int> &next_perimeter(wave.perimeter[!circ_index]);
         ++travel_distance;
-        for (const coord_def &p : perimeter)
+        for (const int index : perimeter)
         {
+            const coord_def p(index / GYM, index % GYM);
             const noise_cell &cell(cells(p));
 
-            if (!cell.silent())
-            {
-                apply_noise_effects(p,
-                                    cell.noise_intensity_millis,
-                                    noises[cell.noise_id]);
+            if (cell.silent())
+                continue;
+
+            apply_noise_effects(p, cell.noise_intensity_millis,
+                                noises[cell.noise_id]);
 
-                const int attenuation = _noise_attenuation_millis(p);
-                // If the base noise attenuation kills the noise, go no farther:
-                if (noise_is_audible(cell.noise_intensity_millis - attenuation))
+            const int attenuation = wave.attenuation(index);
+            // If the base noise attenuation kills the noise, go no farther:
+            if (!noise_is_audible(cell.noise_intensity_millis - attenuation))
+                continue;
+
+            // Squares outside the map's inner bounds are always blocked, so
+            // a square noise got into has all its neighbours on the map.
+            for (int dir = 0; dir < 8; ++dir)
+            {
+                const int next_index = index + _noise_neighbour_offsets[dir];
+                if (!wave.blocked(next_index)
+                    && propagate_noise_to_neighbour(
+                           attenuation, travel_distance, cell, p,
+                           p + _noise_neighbour_deltas[dir]))
                 {
-                    // [ds] Not using adjacent iterator which has
-                    // unnecessary overhead for the tight loop here.
-                    for (int xi = -1; xi <= 1; ++xi)
-                    {
-                        for (int yi = -1; yi <= 1; ++yi)
-                        {
-                            if (xi || yi)
-                            {
-                                const coord_def next_position(p.x + xi,
-                                                              p.y + yi);
-                                if (in_bounds(next_position)
-                                    && !silenced(next_position))
-                                {
-                                    if (propagate_noise_to_neighbour(
-                                            attenuation,
-                                            travel_distance,
-                                            cell, p,
-                                            next_position))
-                                    {
-                                        next_perimeter.push_back(next_position);
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    next_perimeter.push_back(next_index);
                 }
             }
         }
 
-        noise_perimeter[circ_index].clear();
+        wave.perimeter[circ_index].clear();
         circ_index = !circ_index;
     }
 
@@ -350,12 +350,16 @@ static const unsigned short ripple_table[] =
 static cglyph_t _get_cell_glyph_with_class(const map_cell& cell,
                                            const coord_def& loc,
                                            const show_class cls,
-                                           int colour_mode)
+                                           int colour_mode,
+                                           bool *animated)
 {
     const bool coloured = colour_mode == 0 ? cell.visible() : (colour_mode > 0);
     cglyph_t g;
     show_type show;
 
+    if (animated)
+        *animated = false;
+
     g.ch = 0;
     const cloud_type cell_cloud = cell.cloud();
 
@@ -558,6 +562,10 @@ static cglyph_t _get_cell_glyph_with_class(const map_cell& cell,
                                                           : fdef.symbol();
     }
 
+    // Element colours can change every time they are drawn.
+    if (animated)
+        *animated = is_element_colour(g.col);
+
     if (g.col)
         g.col = real_colour(g.col, loc);
 
@@ -565,14 +573,15 @@ static cglyph_t _get_cell_glyph_with_class(const map_cell& cell,
 }
 
 cglyph_t get_cell_glyph(const coord_def& loc, bool only_stationary_monsters,
-                        int colour_mode)
+                        int colour_mode, bool *animated)
 {
     // note: this does NOT determine output of the player glyph;
     // that's handled by itself in _draw_player() in view.cc
     const map_cell& cell = env.map_knowledge(loc);
     const show_class cell_show_class =
         get_cell_show_class(cell, only_stationary_monsters);
-    return _get_cell_glyph_with_class(cell, loc, cell_show_class, colour_mode);
+    return _get_cell_glyph_with_class(cell, loc, cell_show_class, colour_mode,
+                                      animated);
 }
 
 char32_t get_feat_symbol(dungeon_feature_type feat)
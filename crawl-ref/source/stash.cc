@@ -962,11 +962,13 @@ void LevelStashes::remove_shop(const coord_def& c)
 
 LevelStashes &StashTracker::get_current_level()
 {
+    load_level(level_id::current());
     return levels[level_id::current()];
 }
 
 LevelStashes *StashTracker::find_level(const level_id &id)
 {
+    load_level(id);
     return map_find(levels, id);
 }
 
@@ -1005,6 +1007,7 @@ bool StashTracker::unmark_trapping_nets(const coord_def &c)
 void StashTracker::remove_level(const level_id &place)
 {
     levels.erase(place);
+    stored.erase(place);
 }
 
 void StashTracker::add_stash(coord_def p)
@@ -1029,6 +1032,7 @@ void StashTracker::dump(const char *filename, bool identify) const
 void StashTracker::write(FILE *f, bool identify) const
 {
     fprintf(f, "%s\n\n", OUTS(you.your_name));
+    load_all_levels();
     if (!levels.size())
         fprintf(f, "  You have no stashes.\n");
     else
@@ -1038,17 +1042,19 @@ void StashTracker::write(FILE *f, bool identify) const
     }
 }
 
+// The levels themselves go in their own chunks, see save_levels().
 void StashTracker::save(writer& outf) const
 {
     // Time of last corpse update.
     marshallInt(outf, last_corpse_update);
 
     // How many levels have we?
-    marshallShort(outf, (short) levels.size());
+    marshallShort(outf, (short) (levels.size() + stored.size()));
 
-    // And ask each level to write itself to the tag
     for (const auto &entry : levels)
-        entry.second.save(outf);
+        entry.first.save(outf);
+    for (const level_id &lev : stored)
+        lev.save(outf);
 }
 
 void StashTracker::load(reader& inf)
@@ -1059,13 +1065,72 @@ void StashTracker::load(reader& inf)
     int count = unmarshallShort(inf);
 
     levels.clear();
+    stored.clear();
     for (int i = 0; i < count; ++i)
     {
-        LevelStashes st;
-        st.load(inf);
-        if (st.has_stashes())
-            levels[st.where()] = st;
+#if TAG_MAJOR_VERSION == 34
+        if (inf.getMinorVersion() < TAG_MINOR_LEVEL_CHUNKS)
+        {
+            LevelStashes st;
+            st.load(inf);
+            if (st.has_stashes())
+                levels[st.where()] = st;
+            continue;
+        }
+#endif
+        level_id id;
+        id.load(inf);
+        stored.insert(id);
+    }
+}
+
+// Write every level that has been loaded to its own chunk. The others are
+// still in the save as they were, so they're left alone.
+void StashTracker::save_levels(package *save) const
+{
+    set<string> keep;
+    for (const auto &entry : levels)
+    {
+        const string chunk = level_chunk_name("st", entry.first);
+        writer outf(save, chunk);
+        write_save_version(outf, save_version::current());
+        entry.second.save(outf);
+        keep.insert(chunk);
     }
+    for (const level_id &lev : stored)
+        keep.insert(level_chunk_name("st", lev));
+
+    delete_stale_level_chunks(save, "st", keep);
+}
+
+void StashTracker::load_level(const level_id &id) const
+{
+    if (!stored.erase(id))
+        return;
+
+    const string chunk = level_chunk_name("st", id);
+    if (!you.save || !you.save->has_chunk(chunk))
+        die("missing stash chunk %s", chunk.c_str());
+
+    reader inf(you.save, chunk);
+    const auto version = get_save_version(inf);
+    if (version.major != TAG_MAJOR_VERSION || version.minor > TAG_MINOR_VERSION)
+    {
+        die("stash chunk %s has unsupported version %d.%d", chunk.c_str(),
+            version.major, version.minor);
+    }
+    inf.setMinorVersion(version.minor);
+
+    LevelStashes st;
+    st.load(inf);
+    if (st.has_stashes())
+        levels[id] = st;
+}
+
+void StashTracker::load_all_levels() const
+{
+    while (!stored.empty())
+        load_level(*stored.begin());
 }
 
 void StashTracker::update_visible_stashes()
@@ -1486,6 +1551,10 @@ void StashTracker::get_matching_stashes(
     const
 {
     level_id curr = level_id::current();
+    if (curr_lev)
+        load_level(curr);
+    else
+        load_all_levels();
     for (const auto &entry : levels)
     {
         if (curr_lev && curr != entry.first)
@@ -1745,6 +1814,7 @@ void StashTracker::update_corpses()
 
     last_corpse_update = you.elapsed_time;
 
+    load_all_levels();
     for (auto &entry : levels)
         entry.second._update_corpses(rot_time);
 }
@@ -1754,6 +1824,7 @@ void StashTracker::update_identification()
     if (!have_passive(passive_t::identify_items))
         return;
 
+    load_all_levels();
     for (auto &entry : levels)
         entry.second._update_identification();
 }
@@ -1762,6 +1833,7 @@ void StashTracker::update_identification()
 
 ST_ItemIterator::ST_ItemIterator()
 {
+    StashTrack.load_all_levels();
     m_stash_level_it = StashTrack.levels.begin();
     new_level();
     //(*this)++;
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,7 @@
 #include "trap-type.h"
 
 class input_history;
+class package;
 class reader;
 class writer;
 class StashMenu;
@@ -269,6 +271,8 @@ public:
 
     void save(writer&) const;
     void load(reader&);
+    void save_levels(package *save) const;
+    void load_all_levels() const;
 
     void write(FILE *f, bool identify = false) const;
 
@@ -287,10 +291,14 @@ private:
                                 bool nohl,
                                 size_t num_alt_matches);
     string stash_search_prompt();
+    void load_level(const level_id &id) const;
 
 private:
     typedef map<level_id, LevelStashes> stash_levels_t;
-    stash_levels_t levels;
+    // Levels are read from their own save chunks when first needed; until
+    // then, they're only listed in stored.
+    mutable stash_levels_t levels;
+    mutable set<level_id> stored;
 
     int last_corpse_update;
 
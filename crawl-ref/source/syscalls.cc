@@ -21,6 +21,7 @@
 # include <fcntl.h>
 # include <sys/types.h>
 # include <sys/stat.h>
+# include <sys/mman.h>
 #endif
 
 #include "files.h"
@@ -533,3 +534,73 @@ int open_u(const char *pathname, int flags, mode_t mode)
     return open(OUTS(pathname), flags, mode);
 #endif
 }
+
+mapped_file::mapped_file(const string &filename)
+    : m_data(nullptr), m_size(0), m_mapped(false)
+{
+#if defined(UNIX) && !defined(__ANDROID__)
+    const int fd = open_u(filename.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        return;
+
+    struct stat st;
+    if (!fstat(fd, &st) && st.st_size > 0)
+    {
+        void *map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED)
+        {
+            m_data   = static_cast<const unsigned char *>(map);
+            m_size   = st.st_size;
+            m_mapped = true;
+        }
+    }
+    // The mapping stays valid after the descriptor is closed.
+    close(fd);
+    if (m_mapped)
+        return;
+#endif
+
+    FILE *fp = fopen_u(filename.c_str(), "rb");
+    if (!fp)
+        return;
+
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        m_buf.insert(m_buf.end(), buf, buf + n);
+    const bool failed = ferror(fp);
+    fclose(fp);
+
+    if (!failed && !m_buf.empty())
+    {
+        m_data = m_buf.data();
+        m_size = m_buf.size();
+    }
+}
+
+mapped_file::mapped_file(int fd, size_t size)
+    : m_data(nullptr), m_size(0), m_mapped(false)
+{
+#if defined(UNIX) && !defined(__ANDROID__)
+    if (fd == -1 || !size)
+        return;
+
+    void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map != MAP_FAILED)
+    {
+        m_data   = static_cast<const unsigned char *>(map);
+        m_size   = size;
+        m_mapped = true;
+    }
+#else
+    UNUSED(fd, size);
+#endif
+}
+
+mapped_file::~mapped_file()
+{
+#if defined(UNIX) && !defined(__ANDROID__)
+    if (m_mapped)
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+#endif
+}
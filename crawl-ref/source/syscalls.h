@@ -5,10 +5,15 @@
 
 #pragma once
 
+#include <string>
 #include <sys/types.h>
+#include <vector>
 
 #include "config.h"
 
+using std::string;
+using std::vector;
+
 bool lock_file(int fd, bool write, bool wait = false);
 bool unlock_file(int fd);
 
@@ -36,3 +41,28 @@ int unlink_u(const char *pathname);
 FILE *fopen_u(const char *path, const char *mode);
 int mkdir_u(const char *pathname, mode_t mode);
 int open_u(const char *pathname, int flags, mode_t mode);
+
+// A read-only view of a whole file. Where mmap() is available the file is
+// mapped shared, so that several processes reading the same cache share one
+// copy in the page cache; elsewhere its contents are read into memory.
+class mapped_file
+{
+public:
+    mapped_file(const string &filename);
+    // Map the first size bytes of an open file. There's no fallback here:
+    // if the file can't be mapped, the result is just invalid.
+    mapped_file(int fd, size_t size);
+    ~mapped_file();
+
+    bool valid() const { return m_data; }
+    const unsigned char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    DISALLOW_COPY_AND_ASSIGN(mapped_file);
+
+private:
+    const unsigned char *m_data;
+    size_t m_size;
+    bool m_mapped;
+    vector<unsigned char> m_buf;
+};
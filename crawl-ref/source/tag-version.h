@@ -255,6 +255,8 @@ enum tag_minor_version
     TAG_MINOR_REALLY_UNSTACK_EVOKERS, // Unstack all evokers
     TAG_MINOR_SETPOLY,             // Despoiler polymorph wands
     TAG_MINOR_GOLDIFY_MANUALS,     // Move manuals out of the inventory
+    TAG_MINOR_GRID_SPANS,          // Save level grids whole, not by cell
+    TAG_MINOR_LEVEL_CHUNKS,        // Travel cache and stashes chunk per level
 #endif
     NUM_TAG_MINORS,
     TAG_MINOR_VERSION = NUM_TAG_MINORS - 1
@@ -109,16 +109,16 @@ extern set<pair<string, level_id> > auto_unique_annotations;
 extern abyss_state abyssal_state;
 
 reader::reader(const string &_read_filename, int minorVersion)
-    : _filename(_read_filename), _chunk(0), _pbuf(nullptr), _read_offset(0),
-      _minorVersion(minorVersion), _safe_read(false)
+    : _filename(_read_filename), _chunk(0), _pbuf(nullptr), _pbuf_size(0),
+      _read_offset(0), _minorVersion(minorVersion), _safe_read(false)
 {
     _file       = fopen_u(_filename.c_str(), "rb");
     opened_file = !!_file;
 }
 
 reader::reader(package *save, const string &chunkname, int minorVersion)
-    : _file(0), _chunk(0), opened_file(false), _pbuf(0), _read_offset(0),
-     _minorVersion(minorVersion), _safe_read(false)
+    : _file(0), _chunk(0), opened_file(false), _pbuf(0), _pbuf_size(0),
+      _read_offset(0), _minorVersion(minorVersion), _safe_read(false)
 {
     ASSERT(save);
     _chunk = new chunk_reader(save, chunkname);
@@ -153,7 +153,7 @@ void reader::advance(size_t offset)
 bool reader::valid() const
 {
     return (_file && !feof(_file)) ||
-           (_pbuf && _read_offset < _pbuf->size());
+           (_pbuf && _read_offset < _pbuf_size);
 }
 
 static NORETURN void _short_read(bool safe_read)
@@ -184,9 +184,9 @@ unsigned char reader::readByte()
     }
     else
     {
-        if (_read_offset >= _pbuf->size())
+        if (_read_offset >= _pbuf_size)
             _short_read(_safe_read);
-        return (*_pbuf)[_read_offset++];
+        return _pbuf[_read_offset++];
     }
 }
 
@@ -209,10 +209,10 @@ void reader::read(void *data, size_t size)
     }
     else
     {
-        if (_read_offset+size > _pbuf->size())
+        if (_read_offset+size > _pbuf_size)
             _short_read(_safe_read);
         if (data && size)
-            memcpy(data, &(*_pbuf)[_read_offset], size);
+            memcpy(data, _pbuf + _read_offset, size);
 
         _read_offset += size;
     }
@@ -234,7 +234,7 @@ void reader::fail_if_not_eof(const string &name)
     char dummy;
     if (_chunk ? _chunk->read(&dummy, 1) :
         _file ? (fgetc(_file) != EOF) :
-        _read_offset >= _pbuf->size())
+        _read_offset >= _pbuf_size)
     {
         fail("Incomplete read of \"%s\" - aborting.", name.c_str());
     }
@@ -417,6 +417,92 @@ int32_t unmarshallInt(reader &th)
     return data;
 }
 
+// Spans are converted to or from network order through a small buffer, in
+// plain loops over fixed-width values that the compiler can vectorise, and
+// then go through the writer or reader in one call.
+#define SPAN_BUFSIZE 4096
+
+void marshallUBytes(writer &th, const uint8_t *data, size_t count)
+{
+    th.write(data, count);
+}
+
+void unmarshallUBytes(reader &th, uint8_t *data, size_t count)
+{
+    th.read(data, count);
+}
+
+void marshallShorts(writer &th, const int16_t *data, size_t count)
+{
+    uint8_t buf[SPAN_BUFSIZE];
+    while (count)
+    {
+        const size_t n = min(count, sizeof(buf) / 2);
+        for (size_t i = 0; i < n; i++)
+        {
+            const uint16_t v = data[i];
+            buf[2 * i]     = v >> 8;
+            buf[2 * i + 1] = v;
+        }
+        th.write(buf, n * 2);
+        data  += n;
+        count -= n;
+    }
+}
+
+void unmarshallShorts(reader &th, int16_t *data, size_t count)
+{
+    uint8_t buf[SPAN_BUFSIZE];
+    while (count)
+    {
+        const size_t n = min(count, sizeof(buf) / 2);
+        th.read(buf, n * 2);
+        for (size_t i = 0; i < n; i++)
+            data[i] = (int16_t)(buf[2 * i] << 8 | buf[2 * i + 1]);
+        data  += n;
+        count -= n;
+    }
+}
+
+void marshallInts(writer &th, const int32_t *data, size_t count)
+{
+    uint8_t buf[SPAN_BUFSIZE];
+    while (count)
+    {
+        const size_t n = min(count, sizeof(buf) / 4);
+        for (size_t i = 0; i < n; i++)
+        {
+            const uint32_t v = data[i];
+            buf[4 * i]     = v >> 24;
+            buf[4 * i + 1] = v >> 16;
+            buf[4 * i + 2] = v >> 8;
+            buf[4 * i + 3] = v;
+        }
+        th.write(buf, n * 4);
+        data  += n;
+        count -= n;
+    }
+}
+
+void unmarshallInts(reader &th, int32_t *data, size_t count)
+{
+    uint8_t buf[SPAN_BUFSIZE];
+    while (count)
+    {
+        const size_t n = min(count, sizeof(buf) / 4);
+        th.read(buf, n * 4);
+        for (size_t i = 0; i < n; i++)
+        {
+            data[i] = (int32_t)((uint32_t)buf[4 * i] << 24
+                                | (uint32_t)buf[4 * i + 1] << 16
+                                | (uint32_t)buf[4 * i + 2] << 8
+                                | (uint32_t)buf[4 * i + 3]);
+        }
+        data  += n;
+        count -= n;
+    }
+}
+
 void marshallUnsigned(writer& th, uint64_t v)
 {
     do
@@ -474,6 +560,8 @@ void _marshallFixedBitVector(writer& th, const FixedBitVector<SIZE>& arr)
         if (arr[last_bit])
             break;
 
+    uint8_t bytes[SIZE / 7 + 1];
+    int len = 0;
     int i = 0;
     while (1)
     {
@@ -482,13 +570,14 @@ void _marshallFixedBitVector(writer& th, const FixedBitVector<SIZE>& arr)
             if (i < SIZE && arr[i++])
                 byte |= 1 << j;
         if (i <= last_bit)
-            marshallUByte(th, byte);
+            bytes[len++] = byte;
         else
         {
-            marshallUByte(th, byte | 0x80);
+            bytes[len++] = byte | 0x80;
             break;
         }
     }
+    marshallUBytes(th, bytes, len);
 }
 
 template<int SIZE>
@@ -4517,13 +4606,23 @@ static void _tag_construct_level(writer &th)
 
     CANARY;
 
+    // The fixed-size grids go out whole, column by column.
+    {
+        uint8_t feats[GXM * GYM];
+        int32_t props[GXM * GYM];
+        int n = 0;
+        for (int count_x = 0; count_x < GXM; count_x++)
+            for (int count_y = 0; count_y < GYM; count_y++, n++)
+            {
+                feats[n] = env.grid[count_x][count_y];
+                props[n] = env.pgrid[count_x][count_y].flags;
+            }
+        marshallUBytes(th, feats, n);
+        marshallInts(th, props, n);
+    }
     for (int count_x = 0; count_x < GXM; count_x++)
         for (int count_y = 0; count_y < GYM; count_y++)
-        {
-            marshallByte(th, env.grid[count_x][count_y]);
             marshallMapCell(th, env.map_knowledge[count_x][count_y]);
-            marshallInt(th, env.pgrid[count_x][count_y].flags);
-        }
 
     marshallBoolean(th, !!env.map_forgotten);
     if (env.map_forgotten)
@@ -4579,8 +4678,11 @@ static void _tag_construct_level(writer &th)
     if (env.heightmap)
     {
         grid_heightmap &heightmap(*env.heightmap);
+        vector<int16_t> heights;
+        heights.reserve(GXM * GYM);
         for (rectangle_iterator ri(0); ri; ++ri)
-            marshallShort(th, heightmap(*ri));
+            heights.push_back(heightmap(*ri));
+        marshallShorts(th, heights.data(), heights.size());
     }
 
     CANARY;
@@ -5331,7 +5433,7 @@ void marshallMapCell(writer &th, const map_cell &cell)
 
     if (flags & MAP_SERIALIZE_CLOUD)
     {
-        cloud_info* ci = cell.cloudinfo();
+        const cloud_info* ci = cell.cloudinfo();
         marshallUnsigned(th, ci->type);
         marshallUnsigned(th, ci->colour);
         marshallUnsigned(th, ci->duration);
@@ -5987,18 +6089,22 @@ void _tag_construct_level_tiles(writer &th)
     marshallShort(th, tile_env.default_flavour.floor);
     marshallShort(th, tile_env.default_flavour.special);
 
+    vector<int16_t> flv;
+    flv.reserve(GXM * GYM * 7);
     for (int count_x = 0; count_x < GXM; count_x++)
         for (int count_y = 0; count_y < GYM; count_y++)
         {
-            marshallShort(th, tile_env.flv[count_x][count_y].wall_idx);
-            marshallShort(th, tile_env.flv[count_x][count_y].floor_idx);
-            marshallShort(th, tile_env.flv[count_x][count_y].feat_idx);
-
-            marshallShort(th, tile_env.flv[count_x][count_y].wall);
-            marshallShort(th, tile_env.flv[count_x][count_y].floor);
-            marshallShort(th, tile_env.flv[count_x][count_y].feat);
-            marshallShort(th, tile_env.flv[count_x][count_y].special);
+            const tile_flavour &f = tile_env.flv[count_x][count_y];
+            flv.push_back(f.wall_idx);
+            flv.push_back(f.floor_idx);
+            flv.push_back(f.feat_idx);
+
+            flv.push_back(f.wall);
+            flv.push_back(f.floor);
+            flv.push_back(f.feat);
+            flv.push_back(f.special);
         }
+    marshallShorts(th, flv.data(), flv.size());
 
     marshallInt(th, TILE_WALL_MAX);
 }
@@ -6033,10 +6139,29 @@ static void _tag_read_level(reader &th)
 #if TAG_MAJOR_VERSION == 34
     vector<coord_def> transporters;
 #endif
+#if TAG_MAJOR_VERSION == 34
+    const bool by_cell = th.getMinorVersion() < TAG_MINOR_GRID_SPANS;
+#endif
+    uint8_t feats[GXM * GYM];
+    int32_t cell_props[GXM * GYM];
+#if TAG_MAJOR_VERSION == 34
+    if (!by_cell)
+#endif
+    {
+        unmarshallUBytes(th, feats, GXM * GYM);
+        unmarshallInts(th, cell_props, GXM * GYM);
+    }
     for (int i = 0; i < gx; i++)
         for (int j = 0; j < gy; j++)
         {
-            dungeon_feature_type feat = unmarshallFeatureType(th);
+            const int n = i * GYM + j;
+#if TAG_MAJOR_VERSION == 34
+            if (by_cell)
+                feats[n] = unmarshallUByte(th);
+#endif
+            dungeon_feature_type feat =
+                rewrite_feature(static_cast<dungeon_feature_type>(feats[n]),
+                                th.getMinorVersion());
             env.grid[i][j] = feat;
             ASSERT(feat < NUM_FEATURES);
 
@@ -6047,15 +6172,19 @@ static void _tag_read_level(reader &th)
 #endif
             unmarshallMapCell(th, env.map_knowledge[i][j]);
             // Fixup positions
-            if (env.map_knowledge[i][j].monsterinfo())
-                env.map_knowledge[i][j].monsterinfo()->pos = coord_def(i, j);
-            if (env.map_knowledge[i][j].cloudinfo())
-                env.map_knowledge[i][j].cloudinfo()->pos = coord_def(i, j);
+            if (auto mi = env.map_knowledge[i][j].mutable_monsterinfo())
+                mi->pos = coord_def(i, j);
+            if (auto ci = env.map_knowledge[i][j].mutable_cloudinfo())
+                ci->pos = coord_def(i, j);
 
             env.map_knowledge[i][j].flags &= ~MAP_VISIBLE_FLAG;
             if (env.map_knowledge[i][j].seen())
                 env.map_seen.set(i, j);
-            env.pgrid[i][j].flags = unmarshallInt(th);
+#if TAG_MAJOR_VERSION == 34
+            if (by_cell)
+                cell_props[n] = unmarshallInt(th);
+#endif
+            env.pgrid[i][j].flags = cell_props[n];
 
             env.mgrid[i][j] = NON_MONSTER;
         }
@@ -6223,8 +6352,11 @@ static void _tag_read_level(reader &th)
     {
         env.heightmap.reset(new grid_heightmap);
         grid_heightmap &heightmap(*env.heightmap);
+        vector<int16_t> heights(GXM * GYM);
+        unmarshallShorts(th, heights.data(), heights.size());
+        int n = 0;
         for (rectangle_iterator ri(0); ri; ++ri)
-            heightmap(*ri) = unmarshallShort(th);
+            heightmap(*ri) = heights[n++];
     }
 
     EAT_CANARY;
@@ -6869,6 +7001,8 @@ static void _tag_read_level_monsters(reader &th)
     {
         monster& m = env.mons[i];
         unmarshallMonster(th, m);
+        if (m.type != MONS_NO_MONSTER)
+            mons_slot_used(m);
 
         // place monster
         if (!m.alive())
@@ -7030,18 +7164,21 @@ void _tag_read_level_tiles(reader &th)
     tile_env.default_flavour.floor     = unmarshallShort(th);
     tile_env.default_flavour.special   = unmarshallShort(th);
 
+    vector<int16_t> flv(gx * gy * 7);
+    unmarshallShorts(th, flv.data(), flv.size());
+    const int16_t *f = flv.data();
     for (int x = 0; x < gx; x++)
-        for (int y = 0; y < gy; y++)
+        for (int y = 0; y < gy; y++, f += 7)
         {
-            tile_env.flv[x][y].wall_idx  = unmarshallShort(th);
-            tile_env.flv[x][y].floor_idx = unmarshallShort(th);
-            tile_env.flv[x][y].feat_idx  = unmarshallShort(th);
+            tile_env.flv[x][y].wall_idx  = f[0];
+            tile_env.flv[x][y].floor_idx = f[1];
+            tile_env.flv[x][y].feat_idx  = f[2];
 
             // These get overwritten by _regenerate_tile_flavour
-            tile_env.flv[x][y].wall    = unmarshallShort(th);
-            tile_env.flv[x][y].floor   = unmarshallShort(th);
-            tile_env.flv[x][y].feat    = unmarshallShort(th);
-            tile_env.flv[x][y].special = unmarshallShort(th);
+            tile_env.flv[x][y].wall    = f[3];
+            tile_env.flv[x][y].floor   = f[4];
+            tile_env.flv[x][y].feat    = f[5];
+            tile_env.flv[x][y].special = f[6];
         }
 
     _debug_count_tiles();
@@ -105,6 +105,11 @@ void marshall_level_id(writer& th, const level_id& id);
 void marshallUnsigned(writer& th, uint64_t v);
 void marshallSigned(writer& th, int64_t v);
 
+// The same bytes as marshalling each value in turn, but written in bulk.
+void marshallUBytes  (writer &, const uint8_t *data, size_t count);
+void marshallShorts  (writer &, const int16_t *data, size_t count);
+void marshallInts    (writer &, const int32_t *data, size_t count);
+
 /* ***********************************************************************
  * reader API
  * *********************************************************************** */
@@ -115,11 +120,18 @@ public:
     reader(const string &filename, int minorVersion = TAG_MINOR_INVALID);
     reader(FILE* input, int minorVersion = TAG_MINOR_INVALID)
         : _file(input), _chunk(0), opened_file(false), _pbuf(0),
-          _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
+          _pbuf_size(0), _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
     reader(const vector<unsigned char>& input,
            int minorVersion = TAG_MINOR_INVALID)
-        : _file(0), _chunk(0), opened_file(false), _pbuf(&input),
-          _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
+        : _file(0), _chunk(0), opened_file(false), _pbuf(input.data()),
+          _pbuf_size(input.size()), _read_offset(0),
+          _minorVersion(minorVersion), _safe_read(false) {}
+    // Read from a caller-owned buffer, such as a mapped_file.
+    reader(const unsigned char *input, size_t size,
+           int minorVersion = TAG_MINOR_INVALID)
+        : _file(0), _chunk(0), opened_file(false), _pbuf(input),
+          _pbuf_size(size), _read_offset(0), _minorVersion(minorVersion),
+          _safe_read(false) {}
     reader(package *save, const string &chunkname,
            int minorVersion = TAG_MINOR_INVALID);
     ~reader();
@@ -142,8 +154,9 @@ private:
     FILE* _file;
     chunk_reader *_chunk;
     bool  opened_file;
-    const vector<unsigned char>* _pbuf;
-    unsigned int _read_offset;
+    const unsigned char* _pbuf;
+    size_t _pbuf_size;
+    size_t _read_offset;
     int _minorVersion;
     // always throw an exception rather than dying when reading past EOF
     bool _safe_read;
@@ -165,6 +178,10 @@ void        unmarshallMonster (reader &, monster& item);
 dungeon_feature_type unmarshallFeatureType(reader &);
 level_id    unmarshall_level_id(reader& th);
 
+void        unmarshallUBytes  (reader &, uint8_t *data, size_t count);
+void        unmarshallShorts  (reader &, int16_t *data, size_t count);
+void        unmarshallInts    (reader &, int32_t *data, size_t count);
+
 uint64_t unmarshallUnsigned(reader& th);
 template<typename T>
 static inline void unmarshallUnsigned(reader& th, T& v)
@@ -0,0 +1,51 @@
+-- Level fixtures shared by the benchmarks in this directory.
+--
+-- Load with crawl_require('test/big/arena.lua').
+
+arena = { }
+
+-- One band of each kind, placed at arena.band_anchors() in order.
+arena.bands = { "orc warrior", "gnoll", "hobgoblin", "jackal",
+                "goblin", "kobold", "hill orc", "wolf" }
+
+-- Empty the level: open floor walled in by permanent rock, no monsters.
+function arena.clear()
+  debug.dismiss_monsters()
+  dgn.reset_level()
+  dgn.fill_grd_area(0, 0, dgn.GXM - 1, dgn.GYM - 1, 'permanent_rock_wall')
+  dgn.fill_grd_area(1, 1, dgn.GXM - 2, dgn.GYM - 2, 'floor')
+end
+
+-- Scattered pillars, so that paths aren't simply straight lines.
+function arena.pillars()
+  for x = 6, dgn.GXM - 7, 6 do
+    for y = 5, dgn.GYM - 6, 5 do
+      dgn.grid(x, y, 'stone_wall')
+    end
+  end
+end
+
+-- One corner of each band: the corners of the level and halfway along each
+-- edge, with room for a band three wide and two deep.
+function arena.band_anchors()
+  return { { 3, 3 }, { dgn.GXM - 4, 3 }, { 3, dgn.GYM - 4 },
+           { dgn.GXM - 4, dgn.GYM - 4 }, { dgn.GXM / 2, 3 },
+           { dgn.GXM / 2, dgn.GYM - 4 }, { 3, dgn.GYM / 2 },
+           { dgn.GXM - 4, dgn.GYM / 2 } }
+end
+
+-- Place awake bands of up to six of arena.bands at the band anchors, and
+-- return the positions of the monsters that were placed.
+function arena.place_bands(band_size)
+  local placed = { }
+  for i, anchor in ipairs(arena.band_anchors()) do
+    for j = 0, band_size - 1 do
+      local x = anchor[1] + j % 3
+      local y = anchor[2] + math.floor(j / 3)
+      if dgn.create_monster(x, y, "generate_awake " .. arena.bands[i]) then
+        table.insert(placed, { x, y })
+      end
+    end
+  end
+  return placed
+end
@@ -0,0 +1,40 @@
+-- Benchmark the losight() kernels on the LOS test maps.
+--
+-- Usage: ./crawl -test big/los_kernel
+
+local calls = 20000
+
+local function time_map(map, totals)
+  dgn.reset_level()
+  dgn.tags(map, "no_rotate no_vmirror no_hmirror no_pool_fixup")
+  local function place_map()
+    return dgn.place_map(map, true, true)
+  end
+  dgn.with_map_anchors(30, 30, place_map)
+  you.moveto(30, 30)
+
+  local wide = los.time_losight(30, 30, calls, true)
+  local narrow = los.time_losight(30, 30, calls, false)
+  crawl.stderr(string.format("%-24s %12.0f %12.0f", dgn.name(map),
+                             wide, narrow))
+  totals.wide = totals.wide + wide
+  totals.narrow = totals.narrow + narrow
+  totals.maps = totals.maps + 1
+end
+
+local function time_los_maps()
+  local totals = { wide = 0, narrow = 0, maps = 0 }
+  crawl.stderr(string.format("%-24s %12s %12s", "map", "vector/s",
+                             "scalar/s"))
+  local map = dgn.map_by_tag("debug_los")
+  assert(map, "Could not find debug-los maps (tag 'debug_los')")
+  while map do
+    time_map(map, totals)
+    map = dgn.map_by_tag("debug_los")
+  end
+  crawl.stderr(string.format("%-24s %12.0f %12.0f", "mean",
+                             totals.wide / totals.maps,
+                             totals.narrow / totals.maps))
+end
+
+time_los_maps()
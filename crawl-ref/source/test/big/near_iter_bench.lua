@@ -0,0 +1,54 @@
+-- Benchmark actor_near_iterator and monster_near_iterator, with and without
+-- starting from the monster grid: an arena-style fight on an open level,
+-- and the Abyss filled with monsters.
+--
+-- Usage: ./crawl -test big/near_iter_bench
+
+local rounds = 50
+
+crawl_require('test/big/arena.lua')
+
+local function report(label)
+  local monsters = 0
+  for _ in test.level_monster_iterator() do
+    monsters = monsters + 1
+  end
+  local indexed, found = debug.time_near_iterators(rounds)
+  local scanned, found_scan = debug.time_near_iterators(rounds, false)
+  assert(found == found_scan,
+         "near iteration found " .. found .. " actors, scanning found "
+         .. found_scan)
+  crawl.stderr(string.format("%-8s %3d monsters: indexed %.3fs, "
+                             .. "scanned %.3fs", label, monsters,
+                             indexed, scanned))
+end
+
+local function fill_level(monster, count)
+  local placed = 0
+  for i = 1, count * 10 do
+    if placed >= count then
+      break
+    end
+    local x = crawl.random_range(1, dgn.GXM - 2)
+    local y = crawl.random_range(1, dgn.GYM - 2)
+    if dgn.create_monster(x, y, monster) then
+      placed = placed + 1
+    end
+  end
+end
+
+-- Two armies facing each other across an open level.
+arena.clear()
+you.moveto(2, 2)
+for x = 20, 60, 2 do
+  for y = 10, 60, 4 do
+    dgn.create_monster(x, y, x < 40 and "orc warrior" or "gnoll")
+  end
+end
+report("arena")
+
+-- The Abyss, as full of monsters as it will get.
+debug.goto_place("Abyss")
+test.regenerate_level()
+fill_level("random", 600)
+report("abyss")
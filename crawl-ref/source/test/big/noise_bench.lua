@@ -0,0 +1,48 @@
+-- Benchmark noise propagation: shouting bands, Xom-sized noises and loud
+-- spells going off every turn on a large level with walls and doors.
+--
+-- Usage: ./crawl -test big/noise_bench
+
+local turns = 200
+local band_size = 6
+
+crawl_require('test/big/arena.lua')
+
+local function setup_level()
+  arena.clear()
+
+  -- Rooms with doors and some trees, so that noise has to bend around
+  -- and through terrain that muffles it.
+  for x = 16, dgn.GXM - 17, 16 do
+    dgn.fill_grd_area(x, 1, x, dgn.GYM - 2, 'rock_wall')
+    for y = 6, dgn.GYM - 7, 12 do
+      dgn.grid(x, y, 'closed_door')
+    end
+  end
+  for x = 8, dgn.GXM - 9, 16 do
+    dgn.fill_grd_area(x, 20, x + 2, 22, 'tree')
+  end
+
+  you.moveto(dgn.GXM / 2, dgn.GYM / 2)
+
+  return arena.place_bands(band_size)
+end
+
+local shouters = setup_level()
+local total = 0
+for turn = 1, turns do
+  -- Every band member shouts, as they do on seeing the player.
+  for _, pos in ipairs(shouters) do
+    dgn.noisy(12, pos[1], pos[2])
+  end
+  -- A Xom-sized noise somewhere on the level, and a loud spell near the
+  -- player.
+  dgn.noisy(25, crawl.random_range(1, dgn.GXM - 2),
+            crawl.random_range(1, dgn.GYM - 2))
+  dgn.noisy(20, you.pos())
+  total = total + debug.time_noises()
+end
+
+crawl.stderr(string.format("noise    %d turns, %d shouters: %.3fs "
+                           .. "(%.1f us/turn)", turns, #shouters, total,
+                           total * 1e6 / turns))
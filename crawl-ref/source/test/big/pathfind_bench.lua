@@ -0,0 +1,27 @@
+-- Benchmark monster pathfinding: hostile packs chasing the player across a
+-- large open level.
+--
+-- Usage: ./crawl -test big/pathfind_bench
+
+local rounds = 200
+local pack_size = 6
+
+crawl_require('test/big/arena.lua')
+
+local function setup_level()
+  arena.clear()
+  arena.pillars()
+  you.moveto(dgn.GXM / 2, dgn.GYM / 2)
+  return #arena.place_bands(pack_size)
+end
+
+local function report(label, monsters, seconds, paths)
+  crawl.stderr(string.format("%-8s %d monsters, %d searches, %d paths: "
+                             .. "%.3fs (%.1f us/search)", label, monsters,
+                             monsters * rounds, paths, seconds,
+                             seconds * 1e6 / math.max(monsters * rounds, 1)))
+end
+
+local monsters = setup_level()
+report("search", monsters, debug.time_pathfind(rounds))
+report("shared", monsters, debug.time_pathfind(rounds, true))
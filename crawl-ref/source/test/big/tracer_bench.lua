@@ -0,0 +1,34 @@
+-- Benchmark beam tracers: a crowd of hostile monsters around the player,
+-- all tracing at the player while the player traces at each of them.
+--
+-- Usage: ./crawl -test big/tracer_bench
+
+local rounds = 200
+
+crawl_require('test/big/arena.lua')
+
+local function setup_level()
+  arena.clear()
+
+  local cx, cy = dgn.GXM / 2, dgn.GYM / 2
+  you.moveto(cx, cy)
+
+  -- Fill the player's view with monsters on every other square, so that
+  -- most lines of fire pass several of them.
+  local placed = 0
+  for x = cx - 7, cx + 7 do
+    for y = cy - 7, cy + 7 do
+      if (x + y) % 2 == 0 and (x ~= cx or y ~= cy)
+         and dgn.create_monster(x, y, "generate_awake orc warrior") then
+        placed = placed + 1
+      end
+    end
+  end
+  return placed
+end
+
+local monsters = setup_level()
+local seconds, tracers = debug.time_tracers(rounds)
+crawl.stderr(string.format("tracers  %d monsters, %d tracers: %.3fs "
+                           .. "(%.0f tracers/s)", monsters, tracers, seconds,
+                           tracers / math.max(seconds, 1e-9)))
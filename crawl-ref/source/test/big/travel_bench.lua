@@ -0,0 +1,41 @@
+-- Benchmark travel and explore steps across a large, fully mapped level,
+-- with and without reusing the travel flood of earlier steps.
+--
+-- Usage: ./crawl -test big/travel_bench
+
+local rounds = 40
+
+crawl_require('test/big/arena.lua')
+
+local function setup_level()
+  arena.clear()
+
+  -- Pillars, walls with doors and a few pools, so that paths aren't simply
+  -- straight lines and some squares cost more than one move.
+  arena.pillars()
+  for x = 20, dgn.GXM - 21, 20 do
+    dgn.fill_grd_area(x, 1, x, dgn.GYM - 2, 'rock_wall')
+    for y = 8, dgn.GYM - 9, 16 do
+      dgn.grid(x, y, 'closed_door')
+    end
+  end
+  for x = 10, dgn.GXM - 11, 20 do
+    dgn.fill_grd_area(x, 30, x + 3, 33, 'shallow_water')
+  end
+end
+
+local function report(label, seconds, steps)
+  crawl.stderr(string.format("%-8s %d steps: %.3fs (%.1f us/step)", label,
+                             steps, seconds,
+                             seconds * 1e6 / math.max(steps, 1)))
+end
+
+setup_level()
+local x1, y1, x2, y2 = 2, 2, dgn.GXM - 3, dgn.GYM - 3
+local full, full_steps, full_route = debug.time_travel(rounds, x1, y1, x2, y2,
+                                                       false)
+local reused, steps, route = debug.time_travel(rounds, x1, y1, x2, y2)
+assert(steps == full_steps and route == full_route,
+       "reusing travel floods changed the route")
+report("flood", full, full_steps)
+report("reuse", reused, steps)
@@ -0,0 +1,81 @@
+-- Check that partial invalidation of the global LOS cache after a terrain
+-- change gives the same answers as throwing the whole cache away.
+
+local floor = dgn.find_feature_number("floor")
+local rock_wall = dgn.find_feature_number("rock_wall")
+
+local function probe(cx, cy)
+  local seen = { }
+  for y = -9, 9 do
+    for x = -9, 9 do
+      local px, py = cx + x, cy + y
+      if dgn.in_bounds(px, py) then
+        seen[#seen + 1] = los.cell_see_cell(cx, cy, px, py)
+      else
+        seen[#seen + 1] = false
+      end
+    end
+  end
+  return seen
+end
+
+local function test_invalidation()
+  you.random_teleport()
+  local you_x, you_y = you.pos()
+
+  -- Warm the cache, then flip a nearby cell between wall and floor.
+  probe(you_x, you_y)
+  local x, y = you_x + crawl.random_range(-7, 7),
+               you_y + crawl.random_range(-7, 7)
+  if not dgn.in_bounds(x, y) or (x == you_x and y == you_y) then
+    return
+  end
+  local feat = dgn.grid(x, y)
+  if feat == floor then
+    dgn.terrain_changed(x, y, "rock_wall", false, false)
+  elseif feat == rock_wall then
+    dgn.terrain_changed(x, y, "floor", false, false)
+  else
+    return
+  end
+
+  local partial = probe(you_x, you_y)
+  debug.los_changed()
+  local full = probe(you_x, you_y)
+  for i = 1, #full do
+    assert(partial[i] == full[i],
+           "stale LOS after terrain change at (" .. x .. "," .. y .. ")")
+  end
+end
+
+-- A pair whose window is on the changed cell's row, with the far cell
+-- above it: the only gap between o and q is at p.
+local function test_same_row()
+  local ox, oy = you.pos()
+  dgn.fill_grd_area(ox - 3, oy - 3, ox + 3, oy + 3, 'floor')
+  dgn.grid(ox + 1, oy - 1, 'rock_wall')
+  dgn.grid(ox + 1, oy, 'rock_wall')
+  debug.los_changed()
+
+  local qx, qy = ox + 2, oy - 1
+  assert(los.cell_see_cell(ox, oy, qx, qy) == 0, "saw through walls")
+  dgn.terrain_changed(ox + 1, oy, "floor", false, false)
+  local partial = los.cell_see_cell(ox, oy, qx, qy)
+  debug.los_changed()
+  assert(partial == los.cell_see_cell(ox, oy, qx, qy),
+         "stale LOS for a pair on the changed cell's row")
+end
+
+debug.goto_place("D:3")
+debug.flush_map_memory()
+debug.generate_level()
+you.random_teleport()
+test_same_row()
+
+for lev = 1, 3 do
+  debug.flush_map_memory()
+  debug.generate_level()
+  for i = 1, 50 do
+    test_invalidation()
+  end
+end
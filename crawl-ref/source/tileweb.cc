@@ -6,6 +6,7 @@
 
 #include <cerrno>
 #include <cstdarg>
+#include <cstring>
 
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -14,6 +15,7 @@
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
 #include <unistd.h>
 #endif
+#include <zlib.h>
 
 #include "artefact.h"
 #include "branch.h"
@@ -75,11 +77,82 @@ static unsigned int get_milliseconds()
     return ((unsigned int) tv.tv_sec) * 1000 + tv.tv_usec / 1000;
 }
 
+// Receivers that ask for it get each message deflated, as part of a raw
+// deflate stream that lasts as long as they are attached, so that messages
+// are compressed against the ones before them. The deflated data can contain
+// newlines, so each message is framed by a byte that can't start a JSON
+// message and its length, rather than terminated by a newline.
+static const char DEFLATED_MESSAGE = '\x01';
+static const int DEFLATED_HEADER_SIZE = 5;
+
+class message_deflater
+{
+public:
+    message_deflater()
+    {
+        memset(&m_stream, 0, sizeof(m_stream));
+        if (deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                         8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            die("Can't initialise webtiles compression!");
+        }
+    }
+
+    ~message_deflater()
+    {
+        deflateEnd(&m_stream);
+    }
+
+    message_deflater(const message_deflater&) = delete;
+    message_deflater &operator=(const message_deflater&) = delete;
+
+    // Compress msg and return it framed for sending.
+    const string &frame(const string &msg)
+    {
+        m_out.assign(DEFLATED_HEADER_SIZE, '\0');
+        m_stream.next_in = (Bytef *) msg.data();
+        m_stream.avail_in = msg.size();
+        do
+        {
+            const size_t used = m_out.size();
+            const size_t chunk = max<size_t>(msg.size() / 4, 1024);
+            m_out.resize(used + chunk);
+            m_stream.next_out = (Bytef *) &m_out[used];
+            m_stream.avail_out = chunk;
+            if (deflate(&m_stream, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+                die("Webtiles compression error!");
+            m_out.resize(used + chunk - m_stream.avail_out);
+        }
+        while (m_stream.avail_out == 0);
+
+        const uint32_t len = m_out.size() - DEFLATED_HEADER_SIZE;
+        m_out[0] = DEFLATED_MESSAGE;
+        m_out[1] = (len >> 24) & 0xFF;
+        m_out[2] = (len >> 16) & 0xFF;
+        m_out[3] = (len >> 8) & 0xFF;
+        m_out[4] = len & 0xFF;
+        return m_out;
+    }
+
+    // Start afresh, without reference to anything compressed before.
+    void reset()
+    {
+        deflateReset(&m_stream);
+    }
+
+private:
+    z_stream m_stream;
+    string m_out;
+};
+
 TilesFramework tiles;
 
 TilesFramework::TilesFramework() :
       m_controlled_from_web(false),
       _send_lock(false),
+      m_send_socket_stats(false),
+      m_send_keyframes(false),
+      m_last_socket_stats(0),
       m_last_ui_state(UI_INIT),
       m_view_loaded(false),
       m_current_view(coord_def(GXM, GYM)),
@@ -107,6 +180,15 @@ void TilesFramework::shutdown()
     if (m_sock_name.empty())
         return;
 
+    // Make sure the server gets the last messages, such as the exit reason.
+    for (webtiles_receiver &dest : m_dest_addrs)
+    {
+        if (dest.primary)
+            _drain_backlog(dest);
+        else
+            _flush_backlog(dest);
+    }
+
     close(m_sock);
     remove(m_sock_name.c_str());
 }
@@ -181,6 +263,180 @@ void TilesFramework::write_message(const char *format, ...)
     m_msg_buf.append(buf);
 }
 
+// How much a receiver may fall behind before something is done about it:
+// the primary receiver is waited for, watchers have messages dropped.
+static const size_t MAX_BACKLOG_BYTES = 512 * 1024;
+// How many datagrams to hand the socket at once.
+static const int SEND_BATCH = 64;
+// How often to report webtiles_socket_stats to the server, in milliseconds.
+static const unsigned int SOCKET_STATS_INTERVAL = 60 * 1000;
+
+/**
+ * Queue a message for one receiver, split into datagrams of at most
+ * m_max_msg_size bytes.
+ */
+void TilesFramework::_queue_datagrams(webtiles_receiver &dest,
+                                      const string &data)
+{
+    for (size_t start = 0; start < data.size(); start += m_max_msg_size)
+    {
+        dest.backlog.push_back({data.substr(start, m_max_msg_size),
+                                start == 0});
+        dest.backlog_bytes += dest.backlog.back().data.size();
+    }
+}
+
+/**
+ * Send as much of a receiver's backlog as the socket will take without
+ * blocking.
+ *
+ * @return false if the receiver has gone away.
+ */
+bool TilesFramework::_flush_backlog(webtiles_receiver &dest)
+{
+    while (!dest.backlog.empty())
+    {
+        int sent;
+#ifdef __linux__
+        mmsghdr msgs[SEND_BATCH];
+        iovec iovs[SEND_BATCH];
+        const int count = min<size_t>(dest.backlog.size(), SEND_BATCH);
+        for (int i = 0; i < count; ++i)
+        {
+            string &data = dest.backlog[i].data;
+            iovs[i].iov_base = &data[0];
+            iovs[i].iov_len = data.size();
+            memset(&msgs[i], 0, sizeof(msgs[i]));
+            msgs[i].msg_hdr.msg_name = &dest.addr;
+            msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_un);
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        sent = sendmmsg(m_sock, msgs, count, MSG_DONTWAIT);
+#else
+        const string &data = dest.backlog.front().data;
+        sent = sendto(m_sock, data.data(), data.size(), MSG_DONTWAIT,
+                      (sockaddr*) &dest.addr, sizeof(sockaddr_un)) < 0 ? -1
+                                                                       : 1;
+#endif
+        if (sent < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS
+                || errno == EINTR)
+            {
+                return true;
+            }
+            else if (errno == ECONNREFUSED || errno == ENOENT)
+            {
+                // the other side is dead
+#ifdef DEBUG_WEBSOCKETS
+                fprintf(stderr, "websocket: receiver gone (%s).\n",
+                        strerror(errno));
+#endif
+                return false;
+            }
+            else
+                die("Socket write error: %s", strerror(errno));
+        }
+
+        for (int i = 0; i < sent; ++i)
+        {
+            dest.backlog_bytes -= dest.backlog.front().data.size();
+            dest.backlog.pop_front();
+        }
+    }
+    return true;
+}
+
+/**
+ * Wait until a receiver has taken its whole backlog.
+ *
+ * @return false if the receiver has gone away.
+ */
+bool TilesFramework::_drain_backlog(webtiles_receiver &dest)
+{
+    const unsigned int start = get_milliseconds();
+    int retries = 30;
+    size_t last_bytes = dest.backlog_bytes;
+    while (true)
+    {
+        if (!_flush_backlog(dest))
+            return false;
+        if (dest.backlog.empty())
+            break;
+
+        // A slow receiver that is still reading gets as long as it needs;
+        // only give up after 30 attempts in a row that sent nothing.
+        if (dest.backlog_bytes < last_bytes)
+            retries = 30;
+        last_bytes = dest.backlog_bytes;
+
+        if (--retries <= 0)
+            die("Socket write error: receiver not reading");
+
+        // Wait for a couple of milliseconds at first (up to five seconds),
+        // then try again.
+        const int sleep_time = retries > 25 ? 2 * 1000
+                             : retries > 10 ? 500 * 1000
+                             : 5000 * 1000;
+#ifdef DEBUG_WEBSOCKETS
+        fprintf(stderr, "websocket: backlog of %u bytes, sleeping for %dms.\n",
+                (unsigned int) dest.backlog_bytes, sleep_time / 1000);
+#endif
+        usleep(sleep_time);
+    }
+
+    const unsigned int blocked = get_milliseconds() - start;
+    m_socket_stats.blocked_ms += blocked;
+    m_socket_stats.max_blocked_ms = max(m_socket_stats.max_blocked_ms,
+                                        blocked);
+    return true;
+}
+
+/**
+ * Give up on sending a watcher what it has fallen behind on; once it has
+ * caught up, everything will be sent again. A message that has been partly
+ * sent is finished, so that the receiver can still tell where messages start.
+ */
+void TilesFramework::_drop_backlog(webtiles_receiver &dest)
+{
+    auto keep = dest.backlog.begin();
+    while (keep != dest.backlog.end() && !keep->starts_message)
+        ++keep;
+    for (auto it = keep; it != dest.backlog.end(); ++it)
+    {
+        dest.backlog_bytes -= it->data.size();
+        if (it->starts_message)
+            m_socket_stats.dropped_messages++;
+    }
+    dest.backlog.erase(keep, dest.backlog.end());
+
+    // Later messages can't refer back to what was dropped.
+    if (dest.deflater)
+        dest.deflater->reset();
+    dest.needs_resync = true;
+}
+
+bool TilesFramework::_have_backlog() const
+{
+    for (const webtiles_receiver &dest : m_dest_addrs)
+        if (!dest.backlog.empty())
+            return true;
+    return false;
+}
+
+void TilesFramework::_flush_backlogs()
+{
+    for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+    {
+        if (!_flush_backlog(m_dest_addrs[i]))
+        {
+            m_dest_addrs.erase(m_dest_addrs.begin() + i);
+            i--;
+        }
+    }
+}
+
 void TilesFramework::finish_message()
 {
     if (m_msg_buf.size() == 0)
@@ -188,6 +444,7 @@ void TilesFramework::finish_message()
 #ifdef DEBUG_WEBSOCKETS
     const int initial_buf_size = m_msg_buf.size();
     fprintf(stderr, "websocket: About to send %d bytes.\n", initial_buf_size);
+    int wire_size = 0;
 #endif
 
     if (m_sock_name.empty())
@@ -197,75 +454,38 @@ void TilesFramework::finish_message()
     }
 
     m_msg_buf.append("\n");
-    const char* fragment_start = m_msg_buf.data();
-    const char* data_end = m_msg_buf.data() + m_msg_buf.size();
-    int fragments = 0;
-    while (fragment_start < data_end)
+    for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
     {
-        int fragment_size = data_end - fragment_start;
-        if (fragment_size > m_max_msg_size)
-            fragment_size = m_max_msg_size;
-        fragments++;
+        webtiles_receiver &dest = m_dest_addrs[i];
+        // Whatever a lagging watcher misses now will be in the resync.
+        if (dest.needs_resync)
+            continue;
 
-        for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
-        {
-            int retries = 30;
-            ssize_t sent = 0;
-            while (sent < fragment_size)
-            {
-                ssize_t retval = sendto(m_sock, fragment_start + sent,
-                    fragment_size - sent, 0, (sockaddr*) &m_dest_addrs[i],
-                    sizeof(sockaddr_un));
+        const string &data = dest.deflater ? dest.deflater->frame(m_msg_buf)
+                                           : m_msg_buf;
 #ifdef DEBUG_WEBSOCKETS
-                fprintf(stderr,
-                            "    trying to send fragment to client %d...", i);
+        wire_size += data.size();
 #endif
-                if (retval <= 0)
-                {
-                    const char *errmsg = retval == 0 ? "No bytes sent"
-                                                     : strerror(errno);
-                    if (--retries <= 0)
-                        die("Socket write error: %s", errmsg);
+        _queue_datagrams(dest, data);
+        bool alive = _flush_backlog(dest);
 
-                    if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
-                        || errno == EINTR || errno == EAGAIN)
-                    {
-                        // Wait for half a second at first (up to five), then
-                        // try again.
-                        const int sleep_time = retries > 25 ? 2 * 1000
-                                             : retries > 10 ? 500 * 1000
-                                             : 5000 * 1000;
-#ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr, "failed (%s), sleeping for %dms.\n",
-                                                    errmsg, sleep_time / 1000);
-#endif
-                        usleep(sleep_time);
-                    }
-                    else if (errno == ECONNREFUSED || errno == ENOENT)
-                    {
-                        // the other side is dead
-#ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr,
-                            "failed (%s), breaking.\n", errmsg);
-#endif
-                        m_dest_addrs.erase(m_dest_addrs.begin() + i);
-                        i--;
-                        break;
-                    }
-                    else
-                        die("Socket write error: %s", errmsg);
-                }
-                else
-                {
-#ifdef DEBUG_WEBSOCKETS
-                    fprintf(stderr, "fragment size %d sent.\n", fragment_size);
-#endif
-                    sent += retval;
-                }
-            }
-        }
+        m_socket_stats.max_backlog_bytes
+            = max(m_socket_stats.max_backlog_bytes, dest.backlog_bytes);
+        m_socket_stats.max_backlog_datagrams
+            = max(m_socket_stats.max_backlog_datagrams, dest.backlog.size());
 
-        fragment_start += fragment_size;
+        if (alive && dest.backlog_bytes > MAX_BACKLOG_BYTES)
+        {
+            if (dest.primary)
+                alive = _drain_backlog(dest);
+            else
+                _drop_backlog(dest);
+        }
+        if (!alive)
+        {
+            m_dest_addrs.erase(m_dest_addrs.begin() + i);
+            i--;
+        }
     }
     m_msg_buf.clear();
     m_need_flush = true;
@@ -274,11 +494,29 @@ void TilesFramework::finish_message()
     if (m_controlled_from_web && m_dest_addrs.size() == 0)
         fprintf(stderr, "No open websockets after finish_message!!\n");
 
-    fprintf(stderr, "websocket: Sent %d bytes in %d fragments.\n",
-                                                initial_buf_size, fragments);
+    fprintf(stderr, "websocket: Queued %d bytes (%d on the wire).\n",
+                                    initial_buf_size, wire_size);
 #endif
 }
 
+void TilesFramework::_send_socket_stats()
+{
+    const webtiles_socket_stats &st = m_socket_stats;
+    // Everyone kept up; don't fill the server's logs.
+    if (!st.max_backlog_bytes && !st.blocked_ms && !st.dropped_messages)
+        return;
+
+    send_message("*{\"msg\":\"socket_stats\",\"max_backlog_bytes\":%u,"
+                 "\"max_backlog_datagrams\":%u,\"blocked_ms\":%u,"
+                 "\"max_blocked_ms\":%u,\"dropped_messages\":%d,"
+                 "\"resyncs\":%d}",
+                 (unsigned int) st.max_backlog_bytes,
+                 (unsigned int) st.max_backlog_datagrams,
+                 st.blocked_ms, st.max_blocked_ms,
+                 st.dropped_messages, st.resyncs);
+    m_socket_stats = webtiles_socket_stats();
+}
+
 void TilesFramework::send_message(const char *format, ...)
 {
     char buf[2048];
@@ -305,8 +543,33 @@ void TilesFramework::flush_messages()
 {
     if (_send_lock)
         return;
+
+    _flush_backlogs();
+
+    // Watchers that had messages dropped get everything again, once they
+    // have caught up with what was already on its way.
+    for (webtiles_receiver &dest : m_dest_addrs)
+    {
+        if (dest.needs_resync && dest.backlog.empty())
+        {
+            for (webtiles_receiver &other : m_dest_addrs)
+                if (other.backlog.empty())
+                    other.needs_resync = false;
+            m_socket_stats.resyncs++;
+            _send_everything();
+            break;
+        }
+    }
+
     unwind_bool no_rentry(_send_lock, true);
 
+    if (m_send_socket_stats
+        && get_milliseconds() - m_last_socket_stats > SOCKET_STATS_INTERVAL)
+    {
+        m_last_socket_stats = get_milliseconds();
+        _send_socket_stats();
+    }
+
     if (m_need_flush)
     {
         send_message("*{\"msg\":\"flush_messages\"}");
@@ -372,9 +635,25 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
     {
         JsonWrapper primary = json_find_member(obj.node, "primary");
         primary.check(JSON_BOOL);
+        JsonWrapper deflate = json_find_member(obj.node, "deflate");
+
+        JsonWrapper stats = json_find_member(obj.node, "socket_stats");
 
-        m_dest_addrs.push_back(addr);
+        webtiles_receiver receiver;
+        receiver.addr = addr;
+        receiver.primary = primary->bool_;
+        if (deflate.node && deflate->tag == JSON_BOOL && deflate->bool_)
+            receiver.deflater = make_shared<message_deflater>();
+        m_dest_addrs.push_back(receiver);
         m_controlled_from_web = primary->bool_;
+        JsonWrapper keyframes = json_find_member(obj.node, "keyframes");
+        if (keyframes.node && keyframes->tag == JSON_BOOL && keyframes->bool_)
+            m_send_keyframes = true;
+        if (stats.node && stats->tag == JSON_BOOL && stats->bool_)
+        {
+            m_send_socket_stats = true;
+            m_last_socket_stats = get_milliseconds();
+        }
     }
     else if (msgtype == "key")
     {
@@ -489,7 +768,12 @@ bool TilesFramework::await_input(wint_t& c, bool block)
             if (block)
             {
                 tiles.flush_messages();
-                result = select(maxfd + 1, &fds, nullptr, nullptr, nullptr);
+                // Keep feeding receivers that are behind while we wait.
+                timeval timeout;
+                timeout.tv_sec = 0;
+                timeout.tv_usec = 20 * 1000;
+                result = select(maxfd + 1, &fds, nullptr, nullptr,
+                                _have_backlog() ? &timeout : nullptr);
             }
             else
             {
@@ -503,7 +787,11 @@ bool TilesFramework::await_input(wint_t& c, bool block)
         while (result == -1 && errno == EINTR);
 
         if (result == 0)
-            return false;
+        {
+            if (!block)
+                return false;
+            _flush_backlogs();
+        }
         else if (result > 0)
         {
             if (!m_sock_name.empty() && FD_ISSET(m_sock, &fds))
@@ -1790,6 +2078,16 @@ void TilesFramework::_send_monster(const coord_def &gc, const monster_info* m,
     json_close_object(true);
 }
 
+static bool _same_screen_cell(const screen_cell_t &a, const screen_cell_t &b)
+{
+    return a.glyph == b.glyph
+           && a.colour == b.colour
+           && a.flash_colour == b.flash_colour
+           && a.tile == b.tile
+           && a.tile.is_highlighted_summoner == b.tile.is_highlighted_summoner
+           && !memcmp(&a.tile.flv, &b.tile.flv, sizeof(a.tile.flv));
+}
+
 void TilesFramework::load_dungeon(const crawl_view_buffer &vbuf,
                                   const coord_def &gc)
 {
@@ -1840,12 +2138,16 @@ void TilesFramework::load_dungeon(const crawl_view_buffer &vbuf,
                 continue;
 
             screen_cell_t *cell = &m_next_view(grid);
+            const screen_cell_t old_cell = *cell;
+            const bool was_dirty = is_dirty(grid);
 
             *cell = ((const screen_cell_t *) vbuf)[x + vbuf.size().x * y];
             pack_cell_overlays(grid, m_next_view);
 
             mark_clean(grid); // Remove redraw flag
-            mark_dirty(grid);
+            // Only send the cells that actually changed.
+            if (was_dirty || !_same_screen_cell(old_cell, *cell))
+                mark_dirty(grid);
         }
 
     m_next_gc = gc;
@@ -1879,11 +2181,18 @@ void TilesFramework::_send_messages()
     webtiles_send_messages();
 }
 
-/*
-  Send everything a newly joined spectator needs
+/**
+ * Send everything a new spectator needs.
+ *
+ * The server may keep this as a keyframe: replayed with the messages that
+ * follow it, it brings later spectators up to date without the game having
+ * to send everything again for each of them.
  */
 void TilesFramework::_send_everything()
 {
+    if (m_send_keyframes)
+        send_message("*{\"msg\":\"keyframe\",\"state\":\"begin\"}");
+
     _send_version();
     _send_options();
     _send_layout();
@@ -1946,6 +2255,9 @@ void TilesFramework::_send_everything()
     m_text_menu.send(true);
 
     ui::sync_ui_state();
+
+    if (m_send_keyframes)
+        send_message("*{\"msg\":\"keyframe\",\"state\":\"end\"}");
 }
 
 void TilesFramework::clrscr()
@@ -8,7 +8,9 @@
 #ifdef USE_TILE_WEB
 
 #include <bitset>
+#include <deque>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <sys/un.h>
@@ -27,6 +29,39 @@
 using std::vector;
 
 class Menu;
+class message_deflater;
+
+// One end of the webtiles socket: the server process, or a watcher.
+struct webtiles_receiver
+{
+    sockaddr_un addr;
+    bool primary = false;
+    // Set if the receiver asked for deflated messages when attaching.
+    shared_ptr<message_deflater> deflater;
+
+    // Datagrams that the socket wouldn't take yet, oldest first.
+    struct datagram
+    {
+        string data;
+        bool starts_message;
+    };
+    deque<datagram> backlog;
+    size_t backlog_bytes = 0;
+    // Messages were dropped, so it needs everything sent again once it
+    // has caught up.
+    bool needs_resync = false;
+};
+
+// How well the receivers are keeping up, since the last report.
+struct webtiles_socket_stats
+{
+    size_t max_backlog_bytes = 0;
+    size_t max_backlog_datagrams = 0;
+    unsigned int blocked_ms = 0;
+    unsigned int max_blocked_ms = 0;
+    int dropped_messages = 0;
+    int resyncs = 0;
+};
 
 enum WebtilesUIState
 {
@@ -220,7 +255,7 @@ protected:
     int m_sock;
     int m_max_msg_size;
     string m_msg_buf;
-    vector<sockaddr_un> m_dest_addrs;
+    vector<webtiles_receiver> m_dest_addrs;
 
     bool m_controlled_from_web;
     bool m_need_flush;
@@ -230,6 +265,18 @@ protected:
     void _await_connection();
     wint_t _handle_control_message(sockaddr_un addr, string data);
     wint_t _receive_control_message();
+    void _queue_datagrams(webtiles_receiver &dest, const string &data);
+    bool _flush_backlog(webtiles_receiver &dest);
+    bool _drain_backlog(webtiles_receiver &dest);
+    void _drop_backlog(webtiles_receiver &dest);
+    bool _have_backlog() const;
+    void _flush_backlogs();
+    void _send_socket_stats();
+
+    webtiles_socket_stats m_socket_stats;
+    bool m_send_socket_stats;
+    bool m_send_keyframes;
+    unsigned int m_last_socket_stats;
 
     struct JsonFrame
     {
@@ -1120,6 +1120,64 @@ static void _fill_exclude_radius(const travel_exclude &exc)
 
 FixedVector<coord_def, GXM * GYM> travel_pathfind::circumference[2];
 
+// The last travel flood made by a travel_pathfind with reuse_flood set.
+//
+// Travel floods out from its destination until it reaches the player, and
+// moves to the square the player was first reached from. A later search
+// towards the same destination from any square this flood had reached would
+// retrace it exactly up to that point, and move to the square that one was
+// first reached from - as long as nothing the flood looked at until then has
+// changed. Checking that is a lot cheaper than flooding again: every square
+// is looked at once, rather than once from each of its neighbours. Explore
+// and travel take many steps in a row towards the same square, so most steps
+// only need to look over the squares between the player and the
+// destination, and only squares newly seen in that part of the flood make
+// us flood again.
+struct travel_flood_record
+{
+    level_id place;
+    coord_def origin;
+    bool ignore_danger;
+    bool try_fallback;
+    bool valid;
+
+    // Every square the flood looked at, in the order it first did so, with
+    // its travel_pathfind::flood_shape() then.
+    vector<pair<coord_def, uint8_t>> touched;
+
+    // For each square, one more than its index in touched, or 0 if the flood
+    // never looked at it.
+    FixedArray<int, GXM, GYM> order;
+
+    // The square each square was first reached from, if it was reached.
+    FixedArray<coord_def, GXM, GYM> reached_from;
+
+    void clear();
+};
+
+void travel_flood_record::clear()
+{
+    for (const auto &touch : touched)
+    {
+        order(touch.first) = 0;
+        reached_from(touch.first).reset();
+    }
+    touched.clear();
+    valid = false;
+}
+
+static travel_flood_record _travel_flood;
+
+// Whether find_travel_pos() reuses travel floods. Only changed for
+// benchmarking.
+static bool _reuse_travel_floods = true;
+
+void set_travel_flood_reuse(bool reuse)
+{
+    _reuse_travel_floods = reuse;
+    _travel_flood.clear();
+}
+
 // already defined in header
 // const int travel_pathfind::UNFOUND_DIST;
 // const int travel_pathfind::INFINITE_DIST;
@@ -1132,7 +1190,7 @@ travel_pathfind::travel_pathfind()
       unexplored_place(), greedy_place(), unexplored_dist(0), greedy_dist(0),
       refdist(nullptr), reseed_points(), features(nullptr), unreachables(),
       point_distance(travel_point_distance), points(0), next_iter_points(0),
-      traveled_distance(0), circ_index(0)
+      traveled_distance(0), circ_index(0), reuse_flood(false)
 {
 }
 
@@ -1175,6 +1233,11 @@ void travel_pathfind::set_annotate_map(bool annotate)
     annotate_map = annotate;
 }
 
+void travel_pathfind::set_reuse_flood(bool reuse)
+{
+    reuse_flood = reuse;
+}
+
 void travel_pathfind::set_distance_grid(travel_distance_grid_t grid)
 {
     point_distance = grid;
@@ -1317,6 +1380,23 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
 
     ignore_hostile = false;
 
+    // Regular travel only ever floods out from its destination, so an
+    // earlier flood towards it may already know our way.
+    if (reuse_flood && runmode == RMODE_TRAVEL && !floodout && !double_flood)
+    {
+        if (reuse_travel_flood())
+            return travel_move();
+
+        _travel_flood.clear();
+        _travel_flood.place = level_id::current();
+        _travel_flood.origin = start;
+        _travel_flood.ignore_danger = ignore_danger;
+        _travel_flood.try_fallback = try_fallback;
+        _travel_flood.valid = true;
+    }
+    else
+        reuse_flood = false;
+
     // For each round, circumference will store all points that were discovered
     // in the previous round of a given distance. Because we check all grids of
     // a certain distance from the starting point in one round, and move
@@ -1614,7 +1694,11 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
     {
         return false;
     }
-    else if (dc == dest)
+
+    if (reuse_flood && !_travel_flood.order(dc))
+        record_flood_touch(c, dc);
+
+    if (dc == dest)
     {
         // Hallelujah, we're home!
         if (_is_safe_move(c))
@@ -1697,6 +1781,80 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
     return false;
 }
 
+// What a travel flood makes of c, once it gets there: whether it travels
+// over it, how long crossing it takes, whether it's an excluded transporter,
+// and how many known transporters land on it.
+uint8_t travel_pathfind::flood_shape(const coord_def &c) const
+{
+    const dungeon_feature_type feat = env.map_knowledge(c).feat();
+    uint8_t shape = _feature_traverse_cost(feat);
+
+    if (_is_travelsafe_square(c, ignore_hostile, ignore_danger, try_fallback))
+        shape |= 1 << 2;
+
+    if (is_excluded(c) && feat == DNGN_TRANSPORTER)
+        shape |= 1 << 3;
+
+    if (env.grid(c) == DNGN_TRANSPORTER_LANDING)
+    {
+        LevelInfo &li = travel_cache.get_level_info(level_id::current());
+        int arrivals = 0;
+        for (const auto &ti : li.get_transporters())
+            if (ti.destination == c)
+                ++arrivals;
+        shape |= min(arrivals, 15) << 4;
+    }
+
+    return shape;
+}
+
+// The flood looks at dc for the first time, coming from c.
+void travel_pathfind::record_flood_touch(const coord_def &c,
+                                         const coord_def &dc)
+{
+    const uint8_t shape = flood_shape(dc);
+    _travel_flood.touched.emplace_back(dc, shape);
+    _travel_flood.order(dc) = _travel_flood.touched.size();
+
+    // A square that's safe to travel on is reached the first time the flood
+    // looks at it, since nothing else changes in the meantime.
+    if (dc == dest || shape & (1 << 2))
+        _travel_flood.reached_from(dc) = c;
+}
+
+// Find the travel move from the last travel flood, if it was towards the
+// same square and everything it looked at before reaching us is unchanged.
+bool travel_pathfind::reuse_travel_flood()
+{
+    const travel_flood_record &flood = _travel_flood;
+    if (!flood.valid
+        || flood.origin != start
+        || flood.ignore_danger != ignore_danger
+        || flood.try_fallback != try_fallback
+        || flood.place != level_id::current())
+    {
+        return false;
+    }
+
+    const int reached = flood.order(dest);
+    if (!reached || flood.reached_from(dest).origin())
+        return false;
+
+    // The flood stops as soon as it looks at us, so what we're like
+    // ourselves doesn't matter.
+    for (int i = 0; i < reached - 1; ++i)
+    {
+        const auto &touch = flood.touched[i];
+        if (flood_shape(touch.first) != touch.second)
+            return false;
+    }
+
+    const coord_def c = flood.reached_from(dest);
+    if (_is_safe_move(c))
+        next_travel_move = c;
+    return true;
+}
+
 void travel_pathfind::good_square(const coord_def &c)
 {
     if (!point_distance[c.x][c.y])
@@ -1803,7 +1961,10 @@ void find_travel_pos(const coord_def& youpos,
     travel_pathfind tp;
 
     if (need_move)
+    {
         tp.set_src_dst(youpos, you.running.pos);
+        tp.set_reuse_flood(_reuse_travel_floods);
+    }
     else
         tp.set_floodseed(youpos);
 
@@ -3461,7 +3622,7 @@ void LevelInfo::update()
     unwind_slime_wall_precomputer slime_wall_neighbours(
         !actor_slime_wall_immune(&you));
     precompute_travel_safety_grid travel_safety_calc;
-    update_stair_distances();
+    update_stair_distances(stair_flood_layout_changed());
 
     vector<coord_def> transporter_positions;
     get_transporters(transporter_positions);
@@ -3480,30 +3641,84 @@ void LevelInfo::set_distance_between_stairs(int a, int b, int dist)
     stair_distances[b * stairs.size() + a] = dist;
 }
 
-void LevelInfo::update_stair_distances()
+// What a stair flood makes of c: whether it travels over it, how long
+// crossing it takes, and whether it follows a transporter from it. Only
+// meaningful while the travel safety grid is precomputed.
+static uint8_t _stair_flood_shape(const coord_def &c)
+{
+    uint8_t shape = _feature_traverse_cost(env.map_knowledge(c).feat());
+
+    if (_is_travelsafe_square(c))
+        shape |= 1 << 2;
+
+    if (env.grid(c) == DNGN_TRANSPORTER)
+        shape |= is_excluded(c) ? 1 << 4 : 1 << 3;
+
+    return shape;
+}
+
+// Has anything the stair floods look at changed since they last ran? Also
+// remembers the current state for next time.
+bool LevelInfo::stair_flood_layout_changed()
+{
+    vector<uint8_t> shapes(GXM * GYM, 0);
+    for (rectangle_iterator ri(1); ri; ++ri)
+        shapes[ri->x * GYM + ri->y] = _stair_flood_shape(*ri);
+
+    vector<pair<coord_def, coord_def>> trans;
+    for (const transporter_info &ti : transporters)
+        trans.emplace_back(ti.position, ti.destination);
+
+    if (shapes == stair_flood_shapes && trans == stair_flood_transporters)
+        return false;
+
+    stair_flood_shapes = move(shapes);
+    stair_flood_transporters = move(trans);
+    return true;
+}
+
+// Floods from the stairs whose distances are unknown, or from all of them if
+// the level's layout changed. A stair that has been flooded from is at
+// distance 0 from itself; remap_stair_distances() gives new stairs -1.
+void LevelInfo::update_stair_distances(bool layout_changed)
 {
     const int nstairs = stairs.size();
-    // Now we update distances for all the stairs, relative to all other
-    // stairs.
-    for (int s = 0; s < nstairs - 1; ++s)
+    vector<bool> flood(nstairs);
+    int nflood = 0;
+    for (int s = 0; s < nstairs; ++s)
+    {
+        flood[s] = layout_changed || stair_distances[s * nstairs + s];
+        if (flood[s])
+            ++nflood;
+    }
+
+    for (int s = 0; s < nstairs; ++s)
     {
+        if (!flood[s])
+            continue;
+
         set_distance_between_stairs(s, s, 0);
 
+        // When every stair floods, the others have already found all
+        // distances to the last one.
+        if (nflood == nstairs && s == nstairs - 1)
+            break;
+
         // For each stair, we need to ask travel to populate the distance
         // array.
         find_travel_pos(stairs[s].position, nullptr, nullptr, nullptr);
 
         // Assume movement distance between stairs is commutative,
         // i.e. going from a->b is the same distance as b->a.
-        for (int other = s + 1; other < nstairs; ++other)
+        for (int other = 0; other < nstairs; ++other)
         {
+            if (other == s || other < s && flood[other])
+                continue;
             const coord_def op = stairs[other].position;
             const int dist = travel_point_distance[op.x][op.y];
             set_distance_between_stairs(s, other, dist);
         }
     }
-    if (nstairs)
-        set_distance_between_stairs(nstairs - 1, nstairs - 1, 0);
 }
 
 void LevelInfo::update_transporter(const coord_def& transpos,
@@ -3558,6 +3773,10 @@ void LevelInfo::update_stair(const coord_def& stairpos, const level_pos &p,
 void LevelInfo::create_placeholder_stair(const coord_def &stair,
                                          const level_pos &dest)
 {
+    vector<coord_def> old_positions;
+    for (const stair_info &si : stairs)
+        old_positions.push_back(si.position);
+
     // If there are any existing placeholders with the same 'dest', zap them.
     erase_if(stairs, [&dest](const stair_info& old_stair)
                      { return old_stair.type == stair_info::PLACEHOLDER
@@ -3570,7 +3789,7 @@ void LevelInfo::create_placeholder_stair(const coord_def &stair,
     placeholder.type        = stair_info::PLACEHOLDER;
     stairs.push_back(placeholder);
 
-    resize_stair_distances();
+    remap_stair_distances(old_positions);
 }
 
 // If a stair leading out of or into a branch has a known destination, all
@@ -3669,7 +3888,9 @@ int LevelInfo::get_stair_index(const coord_def &pos) const
 
 void LevelInfo::correct_stair_list(const vector<coord_def> &s)
 {
-    stair_distances.clear();
+    vector<coord_def> old_positions;
+    for (const stair_info &stair : stairs)
+        old_positions.push_back(stair.position);
 
     // Fix up the grid for the placeholder stair.
     for (stair_info &stair : stairs)
@@ -3733,7 +3954,7 @@ void LevelInfo::correct_stair_list(const vector<coord_def> &s)
             stairs[found].type = env.map_knowledge(pos).seen() ? stair_info::PHYSICAL : stair_info::MAPPED;
     }
 
-    resize_stair_distances();
+    remap_stair_distances(old_positions);
 }
 
 void LevelInfo::correct_transporter_list(const vector<coord_def> &t)
@@ -3779,11 +4000,41 @@ void LevelInfo::correct_transporter_list(const vector<coord_def> &t)
     }
 }
 
-void LevelInfo::resize_stair_distances()
+// Carries the distances between stairs that were in old_positions over to
+// the current stair list. Distances to and from new stairs are -1, including
+// to themselves, until update_stair_distances() floods from them.
+void LevelInfo::remap_stair_distances(const vector<coord_def> &old_positions)
 {
+    const int nold = old_positions.size();
+    const bool known = (int) stair_distances.size() == nold * nold;
+
     const int nstairs = stairs.size();
-    stair_distances.reserve(nstairs * nstairs);
-    stair_distances.resize(nstairs * nstairs, 0);
+    vector<int> old_index(nstairs, -1);
+    for (int s = 0; s < nstairs && known; ++s)
+    {
+        for (int o = nold - 1; o >= 0; --o)
+            if (old_positions[o] == stairs[s].position)
+            {
+                old_index[s] = o;
+                break;
+            }
+    }
+
+    vector<short> distances(nstairs * nstairs, -1);
+    for (int a = 0; a < nstairs; ++a)
+    {
+        if (old_index[a] == -1)
+            continue;
+        for (int b = 0; b < nstairs; ++b)
+        {
+            if (old_index[b] != -1)
+            {
+                distances[a * nstairs + b] =
+                    stair_distances[old_index[a] * nold + old_index[b]];
+            }
+        }
+    }
+    stair_distances = move(distances);
 }
 
 int LevelInfo::distance_between(const stair_info *s1, const stair_info *s2)
@@ -4015,16 +4266,16 @@ bool TravelCache::know_transporter(const coord_def &c)
 {
     if (env.grid(c) == DNGN_TRANSPORTER)
         update_transporter(c);
-    auto i = levels.find(level_id::current());
-    return i == levels.end() ? false : i->second.know_transporter(c);
+    LevelInfo *li = find_level_info(level_id::current());
+    return li && li->know_transporter(c);
 }
 
 bool TravelCache::know_stair(const coord_def &c)
 {
      if (feat_is_stone_stair(env.grid(c)))
          update_stone_stair(c);
-    auto i = levels.find(level_id::current());
-    return i == levels.end() ? false : i->second.know_stair(c);
+    LevelInfo *li = find_level_info(level_id::current());
+    return li && li->know_stair(c);
 }
 
 void TravelCache::list_waypoints() const
@@ -4203,29 +4454,31 @@ int TravelCache::get_waypoint_count() const
 
 void TravelCache::clear_distances()
 {
+    load_all_levels();
     for (auto &entry : levels)
         entry.second.clear_distances();
 }
 
 bool TravelCache::is_known_branch(uint8_t branch) const
 {
+    load_all_levels();
     return any_of(begin(levels), end(levels),
             [branch] (const pair<level_id, LevelInfo> &entry)
             { return entry.second.is_known_branch(branch); });
 }
 
+// The level infos themselves go in their own chunks, see save_levels().
 void TravelCache::save(writer& outf) const
 {
     write_save_version(outf, save_version::current());
 
     // Write level count.
-    marshallShort(outf, levels.size());
+    marshallShort(outf, levels.size() + stored.size());
 
     for (const auto &entry : levels)
-    {
         entry.first.save(outf);
-        entry.second.save(outf);
-    }
+    for (const level_id &lev : stored)
+        lev.save(outf);
 
     for (int wp = 0; wp < TRAVEL_WAYPOINT_COUNT; ++wp)
         waypoints[wp].save(outf);
@@ -4234,6 +4487,7 @@ void TravelCache::save(writer& outf) const
 void TravelCache::load(reader& inf, int minorVersion)
 {
     levels.clear();
+    stored.clear();
 
     // Check version. If not compatible, we just ignore the file altogether.
     const auto version = get_save_version(inf);
@@ -4247,13 +4501,20 @@ void TravelCache::load(reader& inf, int minorVersion)
         level_id id;
         id.load(inf);
 
-        LevelInfo linfo;
-        // Must set id before load, or travel_hell_entry will not be
-        // correctly set.
-        linfo.id = id;
-        linfo.load(inf, minorVersion);
+#if TAG_MAJOR_VERSION == 34
+        if (minor < TAG_MINOR_LEVEL_CHUNKS)
+        {
+            LevelInfo linfo;
+            // Must set id before load, or travel_hell_entry will not be
+            // correctly set.
+            linfo.id = id;
+            linfo.load(inf, minorVersion);
 
-        levels[id] = linfo;
+            levels[id] = linfo;
+            continue;
+        }
+#endif
+        stored.insert(id);
     }
 
     for (int wp = 0; wp < TRAVEL_WAYPOINT_COUNT; ++wp)
@@ -4262,6 +4523,58 @@ void TravelCache::load(reader& inf, int minorVersion)
     fixup_levels();
 }
 
+// Write every level that has been loaded to its own chunk. The others are
+// still in the save as they were, so they're left alone.
+void TravelCache::save_levels(package *save) const
+{
+    set<string> keep;
+    for (const auto &entry : levels)
+    {
+        const string chunk = level_chunk_name("tc", entry.first);
+        writer outf(save, chunk);
+        write_save_version(outf, save_version::current());
+        entry.second.save(outf);
+        keep.insert(chunk);
+    }
+    for (const level_id &lev : stored)
+        keep.insert(level_chunk_name("tc", lev));
+
+    delete_stale_level_chunks(save, "tc", keep);
+}
+
+void TravelCache::load_level(const level_id &lev) const
+{
+    if (!stored.erase(lev))
+        return;
+
+    // The level has already left stored; returning quietly here would lose
+    // its travel data for good.
+    const string chunk = level_chunk_name("tc", lev);
+    if (!you.save || !you.save->has_chunk(chunk))
+        die("missing travel cache chunk %s", chunk.c_str());
+
+    reader inf(you.save, chunk);
+    const auto version = get_save_version(inf);
+    if (version.major != TAG_MAJOR_VERSION || version.minor > TAG_MINOR_VERSION)
+    {
+        die("travel cache chunk %s has unsupported version %d.%d",
+            chunk.c_str(), version.major, version.minor);
+    }
+
+    LevelInfo &li = levels[lev];
+    // Must set id before load, or travel_hell_entry will not be
+    // correctly set.
+    li.id = lev;
+    li.load(inf, version.minor);
+    li.fixup();
+}
+
+void TravelCache::load_all_levels() const
+{
+    while (!stored.empty())
+        load_level(*stored.begin());
+}
+
 void TravelCache::set_level_excludes()
 {
     get_level_info(level_id::current()).set_level_excludes();
@@ -4286,6 +4599,7 @@ unsigned int TravelCache::query_daction_counter(daction_type c)
 {
     // other levels are up to date, the current one not necessarily so
     update_daction_counters();
+    load_all_levels();
 
     unsigned int sum = 0;
 
@@ -4297,6 +4611,7 @@ unsigned int TravelCache::query_daction_counter(daction_type c)
 
 void TravelCache::clear_daction_counter(daction_type c)
 {
+    load_all_levels();
     for (auto &entry : levels)
         entry.second.daction_counters[c] = 0;
 }
@@ -4313,6 +4628,9 @@ vector<level_id> TravelCache::known_levels() const
 
     for (const auto &entry : levels)
         levs.push_back(entry.first);
+    for (const level_id &lev : stored)
+        levs.push_back(lev);
+    sort(levs.begin(), levs.end());
 
     return levs;
 }
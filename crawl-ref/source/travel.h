@@ -6,6 +6,7 @@
 
 #include <cstdio>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -14,6 +15,7 @@
 #include "exclude.h"
 #include "travel-defs.h"
 
+class package;
 class reader;
 class writer;
 
@@ -70,6 +72,7 @@ bool is_unknown_transporter(const coord_def &p);
 
 void find_travel_pos(const coord_def& youpos, int *move_x, int *move_y,
                      vector<coord_def>* coords = nullptr);
+void set_travel_flood_reuse(bool reuse);
 
 bool is_stair_exclusion(const coord_def &p);
 
@@ -383,7 +386,9 @@ private:
 
     void correct_stair_list(const vector<coord_def> &s);
     void correct_transporter_list(const vector<coord_def> &s);
-    void update_stair_distances();
+    bool stair_flood_layout_changed();
+    void update_stair_distances(bool layout_changed);
+    void remap_stair_distances(const vector<coord_def> &old_positions);
     void sync_all_branch_stairs();
     void sync_branch_stairs(const stair_info *si);
     void set_distance_between_stairs(int a, int b, int dist);
@@ -399,11 +404,16 @@ private:
     vector<short> stair_distances;  // Dist between stairs
     level_id id;
 
+    // What the stair floods last made of each square, and where the known
+    // transporters led. Stair distances hold as long as these are unchanged.
+    // Not saved, so the first update after loading refloods every stair.
+    vector<uint8_t> stair_flood_shapes;
+    vector<pair<coord_def, coord_def>> stair_flood_transporters;
+
     friend class TravelCache;
 
 private:
     void create_placeholder_stair(const coord_def &, const level_pos &);
-    void resize_stair_distances();
 };
 
 const int TRAVEL_WAYPOINT_COUNT = 10;
@@ -415,6 +425,7 @@ public:
 
     LevelInfo& get_level_info(const level_id &lev)
     {
+        load_level(lev);
         LevelInfo &li = levels[lev];
         li.id = lev;
         return li;
@@ -422,6 +433,7 @@ public:
 
     LevelInfo *find_level_info(const level_id &lev)
     {
+        load_level(lev);
         map<level_id, LevelInfo>::iterator i = levels.find(lev);
         return i != levels.end()? &i->second : nullptr;
     }
@@ -429,13 +441,14 @@ public:
     void erase_level_info(const level_id& lev)
     {
         levels.erase(lev);
+        stored.erase(lev);
     }
 
     bool know_stair(const coord_def &c);
     bool know_transporter(const coord_def &c);
     bool know_level(const level_id &lev) const
     {
-        return levels.count(lev);
+        return levels.count(lev) || stored.count(lev);
     }
     vector<level_id> known_levels() const;
 
@@ -461,6 +474,8 @@ public:
 
     void save(writer&) const;
     void load(reader&, int minorVersion);
+    void save_levels(package *save) const;
+    void load_all_levels() const;
 
     bool is_known_branch(uint8_t branch) const;
 
@@ -472,10 +487,14 @@ public:
 private:
     void update_stone_stair(const coord_def &c);
     void fixup_levels();
+    void load_level(const level_id &lev) const;
 
 private:
     typedef map<level_id, LevelInfo> travel_levels_map;
-    travel_levels_map levels;
+    // Levels are read from their own save chunks when first needed; until
+    // then, they're only listed in stored.
+    mutable travel_levels_map levels;
+    mutable set<level_id> stored;
     level_pos waypoints[TRAVEL_WAYPOINT_COUNT];
 };
 
@@ -538,6 +557,10 @@ public:
         ignore_danger = true;
     }
 
+    // For regular travel, reuse the flood of an earlier search towards the
+    // same destination when nothing it looked at has changed since.
+    void set_reuse_flood(bool reuse);
+
 protected:
     bool is_greed_inducing_square(const coord_def &c) const;
     bool path_examine_point(const coord_def &c);
@@ -546,6 +569,9 @@ protected:
     bool square_slows_movement(const coord_def &c);
     void check_square_greed(const coord_def &c);
     void good_square(const coord_def &c);
+    bool reuse_travel_flood();
+    void record_flood_touch(const coord_def &c, const coord_def &dc);
+    uint8_t flood_shape(const coord_def &c) const;
 
 protected:
     static const int UNFOUND_DIST  = -30000;
@@ -628,6 +654,9 @@ protected:
     // Attempt to path through temporary obstructions (like sealed doors)
     // due to the possibility they are no longer obstructing us
     bool try_fallback;
+
+    // Whether this travel search reuses and records travel floods.
+    bool reuse_flood;
 };
 
 extern TravelCache travel_cache;
@@ -39,6 +39,7 @@
 #include "items.h"
 #include "item-name.h" // item_type_known
 #include "item-prop.h" // get_weapon_brand
+#include "level-state-type.h"
 #include "libutil.h"
 #include "macro.h"
 #include "map-knowledge.h"
@@ -1100,11 +1101,11 @@ static void _draw_out_of_bounds(screen_cell_t *cell)
 }
 
 static void _draw_outside_los(screen_cell_t *cell, const coord_def &gc,
-                                    const coord_def &ep)
+                                    const coord_def &ep, bool *animated)
 {
 #ifndef USE_TILE_LOCAL
     // Outside the env.show area.
-    cglyph_t g = get_cell_glyph(gc);
+    cglyph_t g = get_cell_glyph(gc, false, 0, animated);
     cell->glyph  = g.ch;
     cell->colour = g.col;
 #endif
@@ -1118,6 +1119,9 @@ static void _draw_outside_los(screen_cell_t *cell, const coord_def &gc,
 #else
     UNUSED(ep);
 #endif
+#ifdef USE_TILE_LOCAL
+    UNUSED(animated);
+#endif
 }
 
 static void _draw_player(screen_cell_t *cell,
@@ -1154,12 +1158,14 @@ static void _draw_player(screen_cell_t *cell,
 
 static void _draw_los(screen_cell_t *cell,
                       const coord_def &gc, const coord_def &ep,
-                      bool anim_updates)
+                      bool anim_updates, bool *animated)
 {
 #ifndef USE_TILE_LOCAL
-    cglyph_t g = get_cell_glyph(gc);
+    cglyph_t g = get_cell_glyph(gc, false, 0, animated);
     cell->glyph  = g.ch;
     cell->colour = g.col;
+#else
+    UNUSED(animated);
 #endif
 
 #ifdef USE_TILE
@@ -1320,6 +1326,8 @@ void run_animation(animation_type anim, use_animation_type type, bool cleanup)
 static bool _view_is_updating = false;
 
 crawl_view_buffer view_dungeon(animation *a, bool anim_updates, view_renderer *renderer);
+static const crawl_view_buffer &_render_view(animation *a, bool anim_updates,
+                                             view_renderer *renderer);
 
 static bool _viewwindow_should_render()
 {
@@ -1417,7 +1425,8 @@ void viewwindow(bool show_updates, bool tiles_only, animation *a, view_renderer
 
         if (_viewwindow_should_render())
         {
-            const auto vbuf = view_dungeon(a, anim_updates, renderer);
+            const crawl_view_buffer &vbuf
+                = _render_view(a, anim_updates, renderer);
 
             you.last_view_update = you.num_turns;
 #ifndef USE_TILE_LOCAL
@@ -1596,18 +1605,356 @@ crawl_view_buffer view_dungeon(animation *a, bool anim_updates, view_renderer *r
     return vbuf;
 }
 
+// What went into each cell of the last frame viewwindow() drew. Cells
+// whose inputs haven't changed since are left as they are in _drawn_vbuf.
+struct drawn_cell
+{
+    coord_def gc;
+    map_cell knowledge;
+    bool seen = false;
+    bool animated = true;
+    uint8_t exclusion = 0;
+#ifdef USE_TILE
+    tileidx_t fg = 0;
+    tileidx_t bg = 0;
+    tileidx_t cloud = 0;
+    tileidx_t show_bg = 0;
+    tile_flavour flv;
+    terrain_property_t pgrid;
+#endif
+
+    bool matches(const coord_def &where) const;
+    void record(const coord_def &where, bool is_animated);
+};
+
+// Things that change the whole view when they change.
+struct drawn_frame
+{
+    coord_def size;
+    coord_def vgrdc;
+    level_id place;
+    bool on_current_level = false;
+    layers_type layers = LAYERS_ALL;
+    bool viewport_weapons = false;
+    bool viewport_monster_hp = false;
+    bool show_travel_trail = false;
+    vector<coord_def> travel_trail;
+    uint32_t level_state = 0;
+    bool forest_awoken = false;
+
+    bool operator==(const drawn_frame &other) const
+    {
+        return size == other.size
+               && vgrdc == other.vgrdc
+               && place == other.place
+               && on_current_level == other.on_current_level
+               && layers == other.layers
+               && viewport_weapons == other.viewport_weapons
+               && viewport_monster_hp == other.viewport_monster_hp
+               && show_travel_trail == other.show_travel_trail
+               && (!show_travel_trail || travel_trail == other.travel_trail)
+               && level_state == other.level_state
+               && forest_awoken == other.forest_awoken;
+    }
+};
+
+static crawl_view_buffer _drawn_vbuf;
+static vector<drawn_cell> _drawn_cells;
+static drawn_frame _drawn_frame;
+static coord_def _drawn_player_pos;
+static bool _drawn_valid = false;
+
+static int _cells_drawn = 0;
+static uint64_t _total_cells_drawn = 0;
+
+static drawn_frame _current_frame()
+{
+    drawn_frame frame;
+    frame.size = crawl_view.viewsz;
+    frame.vgrdc = crawl_view.vgrdc;
+    frame.place = level_id::current();
+    frame.on_current_level = you.on_current_level;
+    frame.layers = _layers;
+    frame.viewport_weapons = crawl_state.viewport_weapons;
+    frame.viewport_monster_hp = crawl_state.viewport_monster_hp;
+    frame.show_travel_trail = Options.show_travel_trail;
+    if (frame.show_travel_trail)
+        frame.travel_trail = env.travel_trail;
+    frame.level_state = env.level_state
+                        & (LSTATE_SLIMY_WALL | LSTATE_ICY_WALL);
+    frame.forest_awoken = env.forest_awoken_until;
+    return frame;
+}
+
+static uint8_t _cell_exclusion(const coord_def &gc)
+{
+    if (!is_excluded(gc))
+        return 0;
+    uint8_t exclusion = is_exclude_root(gc) ? 3 : 1;
+#ifndef USE_TILE_LOCAL
+    // Console exclusion colours only show where travel doesn't colour.
+    if (map_bounds(gc) && travel_colour_override(gc))
+        exclusion |= 4;
+#endif
+    return exclusion;
+}
+
+bool drawn_cell::matches(const coord_def &where) const
+{
+    if (where != gc || animated)
+        return false;
+    if (!map_bounds(gc))
+        return true;
+
+    const bool now_seen = you.on_current_level && you.see_cell(gc);
+    if (seen != now_seen
+        || knowledge != env.map_knowledge(gc)
+        || exclusion != _cell_exclusion(gc))
+    {
+        return false;
+    }
+
+#ifdef USE_TILE
+    if (pgrid != env.pgrid(gc)
+        || memcmp(&flv, &tile_env.flv(gc), sizeof(flv)))
+    {
+        return false;
+    }
+
+    if (crawl_view.in_los_bounds_g(gc))
+    {
+        const coord_def ep = grid2show(gc);
+        if (show_bg != tile_env.bg(ep))
+            return false;
+        if (seen)
+        {
+            return fg == tile_env.fg(ep)
+                   && bg == tile_env.bg(ep)
+                   && cloud == tile_env.cloud(ep);
+        }
+    }
+    return fg == tile_env.bk_fg(gc)
+           && bg == tile_env.bk_bg(gc)
+           && cloud == tile_env.bk_cloud(gc);
+#else
+    return true;
+#endif
+}
+
+void drawn_cell::record(const coord_def &where, bool is_animated)
+{
+    gc = where;
+    animated = is_animated;
+    if (!map_bounds(gc))
+    {
+        knowledge.clear();
+        return;
+    }
+
+    seen = you.on_current_level && you.see_cell(gc);
+    knowledge = env.map_knowledge(gc);
+    exclusion = _cell_exclusion(gc);
+
+#ifdef USE_TILE
+    pgrid = env.pgrid(gc);
+    flv = tile_env.flv(gc);
+
+    show_bg = 0;
+    if (crawl_view.in_los_bounds_g(gc))
+    {
+        const coord_def ep = grid2show(gc);
+        show_bg = tile_env.bg(ep);
+        if (seen)
+        {
+            fg = tile_env.fg(ep);
+            bg = tile_env.bg(ep);
+            cloud = tile_env.cloud(ep);
+        }
+    }
+    if (!seen || !crawl_view.in_los_bounds_g(gc))
+    {
+        fg = tile_env.bk_fg(gc);
+        bg = tile_env.bk_bg(gc);
+        cloud = tile_env.bk_cloud(gc);
+    }
+
+    // Monster doll indices are reused as the mcache is cleared, and these
+    // properties are drawn with a phase that changes from turn to turn.
+    uint32_t phased = MAP_ORB_HALOED | MAP_DISJUNCT;
+#if TAG_MAJOR_VERSION == 34
+    phased |= MAP_HOT;
+#endif
+    if ((fg & TILE_FLAG_MASK) >= TILEP_MCACHE_START
+        || knowledge.flags & phased)
+    {
+        animated = true;
+    }
+#endif
+}
+
+static bool _have_overlays()
+{
+#ifdef USE_TILE
+    if (!tile_overlays.empty())
+        return true;
+#endif
+#ifndef USE_TILE_LOCAL
+    if (!glyph_overlays.empty())
+        return true;
+#endif
+    return false;
+}
+
+/**
+ * Force the next viewwindow() to draw every cell of the view, for when
+ * something outside of what the view keeps track of has changed.
+ */
+void view_redraw_all()
+{
+    _drawn_valid = false;
+}
+
+/**
+ * How many cells the last viewwindow() drew.
+ *
+ * @param[out] total if not null, the number of cells drawn over the
+ *                   whole session.
+ */
+int view_cells_drawn(uint64_t *total)
+{
+    if (total)
+        *total = _total_cells_drawn;
+    return _cells_drawn;
+}
+
+/**
+ * Update _drawn_vbuf for the current state of the dungeon, drawing only
+ * the cells which have changed since the last frame, or all of them if
+ * anything affecting the whole view has changed.
+ */
+static void _draw_changed_cells(bool anim_updates)
+{
+    cursor_control cs(false);
+
+    _sort_overlays();
+
+    int flash_colour = you.flash_colour;
+    if (flash_colour == BLACK)
+        flash_colour = viewmap_flash_colour();
+
+    // Flashes, targeting and overlays last for a frame or two, so draw
+    // them out in full, and everything again once they're gone.
+    const bool transient = flash_colour != BLACK
+                           || you.flash_where
+                           || crawl_state.darken_range
+                           || crawl_state.flash_monsters
+                           || _have_overlays();
+
+    drawn_frame frame = _current_frame();
+    const coord_def size = frame.size;
+    const int ncells = size.x * size.y;
+    bool full = !_drawn_valid || transient || !(frame == _drawn_frame);
+
+    if (_drawn_vbuf.size() != size)
+    {
+        _drawn_vbuf = crawl_view_buffer(size);
+        full = true;
+    }
+    if ((int) _drawn_cells.size() != ncells)
+        _drawn_cells.assign(ncells, drawn_cell());
+
+    vector<bool> redraw(ncells, full);
+    if (!full)
+    {
+        vector<bool> changed(ncells, false);
+        for (rectangle_iterator ri(coord_def(1, 1), size); ri; ++ri)
+        {
+            const int i = (ri->y - 1) * size.x + ri->x - 1;
+            const coord_def gc = view2grid(*ri);
+            if (gc == you.pos() || gc == _drawn_player_pos
+                || !_drawn_cells[i].matches(gc))
+            {
+                changed[i] = true;
+            }
+#ifdef USE_TILE_LOCAL
+            // Animations are stepped as cells are drawn.
+            else if (anim_updates && _drawn_cells[i].seen)
+                changed[i] = true;
+#endif
+        }
+
+        // Cells are drawn differently depending on what's next to them
+        // (unseen edges, slimy and icy walls), so redraw the neighbours too.
+        for (rectangle_iterator ri(coord_def(1, 1), size); ri; ++ri)
+        {
+            if (!changed[(ri->y - 1) * size.x + ri->x - 1])
+                continue;
+            for (int y = max(ri->y - 1, 1); y <= min(ri->y + 1, size.y); ++y)
+                for (int x = max(ri->x - 1, 1); x <= min(ri->x + 1, size.x); ++x)
+                    redraw[(y - 1) * size.x + x - 1] = true;
+        }
+    }
+
+    _cells_drawn = 0;
+    screen_cell_t *cell(_drawn_vbuf);
+    for (rectangle_iterator ri(coord_def(1, 1), size); ri; ++ri, ++cell)
+    {
+        const int i = (ri->y - 1) * size.x + ri->x - 1;
+        if (!redraw[i])
+            continue;
+
+        const coord_def gc = view2grid(*ri);
+        bool animated = false;
+        if (you.flash_where && you.flash_where->is_affected(gc) <= 0)
+            draw_cell(cell, gc, anim_updates, 0, &animated);
+        else
+            draw_cell(cell, gc, anim_updates, flash_colour, &animated);
+        _drawn_cells[i].record(gc, animated);
+        _cells_drawn++;
+    }
+
+    _total_cells_drawn += _cells_drawn;
+    _drawn_frame = move(frame);
+    _drawn_player_pos = you.pos();
+    _drawn_valid = !transient;
+}
+
+/**
+ * Render the main dungeon view into _drawn_vbuf.
+ *
+ * Animations and renderers draw over the whole view, so they go through
+ * view_dungeon(); otherwise only the cells that changed are drawn.
+ */
+static const crawl_view_buffer &_render_view(animation *a, bool anim_updates,
+                                             view_renderer *renderer)
+{
+    if (a || renderer)
+    {
+        _drawn_vbuf = view_dungeon(a, anim_updates, renderer);
+        _drawn_valid = false;
+        _cells_drawn = _drawn_vbuf.size().x * _drawn_vbuf.size().y;
+        _total_cells_drawn += _cells_drawn;
+    }
+    else
+        _draw_changed_cells(anim_updates);
+    return _drawn_vbuf;
+}
+
 void draw_cell(screen_cell_t *cell, const coord_def &gc,
-               bool anim_updates, int flash_colour)
+               bool anim_updates, int flash_colour, bool *animated)
 {
 #ifdef USE_TILE
     cell->tile.clear();
 #endif
     const coord_def ep = grid2show(gc);
 
+    if (animated)
+        *animated = false;
+
     if (!map_bounds(gc))
         _draw_out_of_bounds(cell);
     else if (!crawl_view.in_los_bounds_g(gc))
-        _draw_outside_los(cell, gc, coord_def());
+        _draw_outside_los(cell, gc, coord_def(), animated);
     else if (gc == you.pos() && you.on_current_level
              && _layers & LAYER_PLAYER
              && !crawl_state.game_is_arena()
@@ -1616,9 +1963,9 @@ void draw_cell(screen_cell_t *cell, const coord_def &gc,
         _draw_player(cell, gc, ep, anim_updates);
     }
     else if (you.see_cell(gc) && you.on_current_level)
-        _draw_los(cell, gc, ep, anim_updates);
+        _draw_los(cell, gc, ep, anim_updates, animated);
     else
-        _draw_outside_los(cell, gc, ep); // in los bounds but not visible
+        _draw_outside_los(cell, gc, ep, animated); // in los bounds but not visible
 
 #ifdef USE_TILE
     cell->tile.map_knowledge = map_bounds(gc) ? env.map_knowledge(gc) : map_cell();
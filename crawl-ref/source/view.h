@@ -93,7 +93,9 @@ void run_animation(animation_type anim, use_animation_type type,
 void viewwindow(bool show_updates = true, bool tiles_only = false,
                 animation *a = nullptr, view_renderer *renderer = nullptr);
 void draw_cell(screen_cell_t *cell, const coord_def &gc,
-               bool anim_updates, int flash_colour);
+               bool anim_updates, int flash_colour, bool *animated = nullptr);
+void view_redraw_all();
+int view_cells_drawn(uint64_t *total = nullptr);
 
 void update_monsters_in_view();
 bool handle_seen_interrupt(monster* mons, vector<string>* msgs_buf = nullptr);
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Measure the traffic of a scripted game over the webtiles game socket.
+
+Starts a seeded game of a webtiles build of crawl, attaches to its socket
+asking for deflated messages, plays a fixed sequence of keys and reports
+how many bytes and datagrams the game sent, against what the same messages
+would have taken as plain JSON.
+
+    python3 webserver/bench_game_socket.py --crawl ./crawl
+"""
+
+import argparse
+import json
+import os
+import pty
+import shutil
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+import zlib
+
+DEFLATED_MESSAGE = 0x01
+DEFLATED_HEADER_SIZE = 5
+# See TilesFramework::initialise.
+MAX_DATAGRAM = 2048
+
+# Explore, rest and look around a bit, so that the map, cell and player
+# updates that dominate real games dominate here too.
+DEFAULT_KEYS = "\x1b" + "o" * 20 + "5" * 5 + "hjklyubn" * 3 + "o" * 20
+
+
+class Receiver(object):
+    def __init__(self, sock):
+        self.sock = sock
+        self.decompressobj = zlib.decompressobj(-zlib.MAX_WBITS)
+        self.buffer = b""
+        self.wire_bytes = 0
+        self.datagrams = 0
+        self.json_bytes = 0
+        self.json_datagrams = 0
+        self.messages = 0
+
+    def _message(self, msg):
+        self.messages += 1
+        self.json_bytes += len(msg)
+        self.json_datagrams += -(-len(msg) // MAX_DATAGRAM)
+
+    def drain(self, quiet_time):
+        """Read until the game has been quiet for quiet_time seconds."""
+        self.sock.settimeout(quiet_time)
+        while True:
+            try:
+                data = self.sock.recv(128 * 1024)
+            except socket.timeout:
+                return
+            self.wire_bytes += len(data)
+            self.datagrams += 1
+            data = self.buffer + data
+            if data[0] == DEFLATED_MESSAGE:
+                length = None
+                if len(data) >= DEFLATED_HEADER_SIZE:
+                    length = struct.unpack(">I",
+                                           data[1:DEFLATED_HEADER_SIZE])[0]
+                if length is None or len(data) < DEFLATED_HEADER_SIZE + length:
+                    self.buffer = data
+                else:
+                    self.buffer = b""
+                    self._message(self.decompressobj.decompress(
+                                            data[DEFLATED_HEADER_SIZE:]))
+            elif data[-1] != b"\n"[0]:
+                self.buffer = data
+            else:
+                self.buffer = b""
+                self._message(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--crawl", default="./crawl",
+                        help="path to a webtiles build of crawl")
+    parser.add_argument("--seed", default="1")
+    parser.add_argument("--keys", default=DEFAULT_KEYS,
+                        help="keys to send, one at a time")
+    parser.add_argument("--quiet-time", type=float, default=0.3,
+                        help="seconds without output before the next key")
+    parser.add_argument("--plain", action="store_true",
+                        help="don't ask the game for deflated messages")
+    args = parser.parse_args()
+
+    tmpdir = tempfile.mkdtemp(prefix="crawl-bench")
+    game_socket = os.path.join(tmpdir, "game.socket")
+    our_socket = os.path.join(tmpdir, "bench.socket")
+    master, slave = pty.openpty()
+    game = subprocess.Popen([args.crawl, "-name", "bench",
+                             "-species", "minotaur", "-background", "fighter",
+                             "-seed", args.seed, "-dir", tmpdir,
+                             "-webtiles-socket", game_socket,
+                             "-await-connection"],
+                            stdin=slave, stdout=slave, stderr=subprocess.DEVNULL)
+    try:
+        while not os.path.exists(game_socket):
+            if game.poll() is not None:
+                raise SystemExit("crawl exited before opening its socket")
+            time.sleep(0.1)
+
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 212992)
+        sock.bind(our_socket)
+        receiver = Receiver(sock)
+
+        def send(msg):
+            sock.sendto(json.dumps(msg).encode(), game_socket)
+
+        send({"msg": "attach", "primary": True, "deflate": not args.plain})
+        receiver.drain(args.quiet_time * 3)
+        for key in args.keys:
+            send({"msg": "key", "keycode": ord(key)})
+            receiver.drain(args.quiet_time)
+    finally:
+        game.kill()
+        game.wait()
+        os.close(master)
+        os.close(slave)
+        shutil.rmtree(tmpdir, ignore_errors=True)
+
+    print("messages:      %d" % receiver.messages)
+    print("plain JSON:    %d bytes in %d datagrams"
+          % (receiver.json_bytes, receiver.json_datagrams))
+    print("on the wire:   %d bytes in %d datagrams"
+          % (receiver.wire_bytes, receiver.datagrams))
+    if receiver.json_bytes:
+        print("saved:         %.1f%%"
+              % (100 - 100.0 * receiver.wire_bytes / receiver.json_bytes))
+
+
+if __name__ == "__main__":
+    main()
@@ -131,6 +131,10 @@ max_idle_time = 5 * 60 * 60
 
 use_gzip = True
 
+# Ask crawl processes to deflate the messages they send over the game socket.
+# Crawl versions that don't support this ignore it and send plain JSON.
+game_socket_deflate = True
+
 # Seconds until stale HTTP connections are closed
 # This needs a patch currently not in mainline tornado.
 http_connection_timeout = None
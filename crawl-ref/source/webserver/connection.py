@@ -2,9 +2,11 @@ import fcntl
 import os
 import os.path
 import socket
+import struct
 import tempfile
 import time
 import warnings
+import zlib
 from datetime import datetime
 from datetime import timedelta
 
@@ -13,8 +15,15 @@ from tornado.escape import to_unicode
 from tornado.escape import utf8
 from tornado.ioloop import IOLoop
 
+import config
+import util
 from config import server_socket_path
 
+# Marks a deflated message from crawl; followed by the 4 byte big-endian
+# length of the deflated data.
+DEFLATED_MESSAGE = 0x01
+DEFLATED_HEADER_SIZE = 5
+
 
 class WebtilesSocketConnection(object):
     def __init__(self, socketpath, logger):
@@ -27,6 +36,10 @@ class WebtilesSocketConnection(object):
         self.close_callback = None
 
         self.msg_buffer = None
+        self.deflate = getattr(config, "game_socket_deflate", True)
+        self._decompressobj = None
+        self.wire_bytes_received = 0
+        self.message_bytes_received = 0
 
     def connect(self, primary = True):
         if not os.path.exists(self.crawl_socketpath):
@@ -69,9 +82,15 @@ class WebtilesSocketConnection(object):
                                      self._handle_read,
                                      IOLoop.ERROR | IOLoop.READ)
 
+        if self.deflate:
+            self._decompressobj = zlib.decompressobj(-zlib.MAX_WBITS)
+
         msg = json_encode({
                 "msg": "attach",
-                "primary": primary
+                "primary": primary,
+                "deflate": self.deflate,
+                "socket_stats": True,
+                "keyframes": True,
                 })
 
         self.open = True
@@ -88,20 +107,36 @@ class WebtilesSocketConnection(object):
             pass
 
     def _handle_data(self, data): # type: (bytes) -> None
+        self.wire_bytes_received += len(data)
         if self.msg_buffer is not None:
             data = self.msg_buffer + data
 
+        if data[0] == DEFLATED_MESSAGE:
+            # Deflated messages carry their length, since the deflated data
+            # may well end with a newline.
+            length = None
+            if len(data) >= DEFLATED_HEADER_SIZE:
+                length = struct.unpack(">I", data[1:DEFLATED_HEADER_SIZE])[0]
+            if length is None or len(data) < DEFLATED_HEADER_SIZE + length:
+                self.msg_buffer = data
+            else:
+                self.msg_buffer = None
+                self._handle_message(self._decompressobj.decompress(
+                                            data[DEFLATED_HEADER_SIZE:]))
         # TODO: is this check safe? Decoding won't always work for
         # fragmented messages...
-        if data[-1] != b'\n'[0]:
+        elif data[-1] != b'\n'[0]:
             # All messages from crawl end with \n.
             # If this one doesn't, it's fragmented.
             self.msg_buffer = data
         else:
             self.msg_buffer = None
+            self._handle_message(data)
 
-            if self.message_callback:
-                self.message_callback(to_unicode(data))
+    def _handle_message(self, data): # type: (bytes) -> None
+        self.message_bytes_received += len(data)
+        if self.message_callback:
+            self.message_callback(to_unicode(data))
 
     def send_message(self, data): # type: (str) -> None
         start = datetime.now()
@@ -116,6 +151,10 @@ class WebtilesSocketConnection(object):
             self.logger.warning("Slow socket send: " + str(end - start))
 
     def close(self):
+        if self.socket and self.message_bytes_received:
+            self.logger.info("Game socket closed. (%s received, %s on the wire)",
+                    util.humanise_bytes(self.message_bytes_received),
+                    util.humanise_bytes(self.wire_bytes_received))
         if self.socket:
             IOLoop.current().remove_handler(self.socket.fileno())
             self.socket.close()
@@ -24,19 +24,24 @@ from inotify import DirectoryWatcher
 from terminal import TerminalRecorder
 from util import DynamicTemplateLoader
 from util import dgl_format_str
+from util import humanise_bytes
 from util import parse_where_data
 from ws_handler import CrawlWebSocket
 from ws_handler import remove_in_lobbys
 from ws_handler import update_all_lobbys
 
 try:
-    from typing import Dict, Set, Tuple, Any
+    from typing import Any, Dict, List, Optional, Set, Tuple
 except:
     pass
 
 last_game_id = 0
 
 processes = dict() # type: Dict[str,CrawlProcessHandler]
+
+# How much game output to keep after a keyframe to bring new watchers up to
+# date, before it is cheaper to ask the game for a new keyframe.
+max_keyframe_delta_bytes = 2 * 1024 * 1024
 unowned_process_logger = logging.LoggerAdapter(logging.getLogger(), {})
 
 def find_game_info(socket_dir, socket_file):
@@ -618,6 +623,14 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
         self._purging_timer = None
         self._process_hup_timeout = None
 
+        # The game's last full update, and its messages since, which
+        # together bring a new watcher up to date without asking the game
+        # to send everything again.
+        self._keyframe = None # type: Optional[List[str]]
+        self._keyframe_building = None # type: Optional[List[str]]
+        self._keyframe_deltas = [] # type: List[str]
+        self._keyframe_delta_bytes = 0
+
     def start(self):
         self._purge_locks_and_start(True)
 
@@ -674,6 +687,14 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
         self._stale_lockfile = None
         self._purging_timer = None
         self._process_hup_timeout = None
+
+        # The game's last full update, and its messages since, which
+        # together bring a new watcher up to date without asking the game
+        # to send everything again.
+        self._keyframe = None # type: Optional[List[str]]
+        self._keyframe_building = None # type: Optional[List[str]]
+        self._keyframe_deltas = [] # type: List[str]
+        self._keyframe_delta_bytes = 0
         self.handle_process_end()
 
     def _find_lock(self):
@@ -870,9 +891,24 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
     def add_watcher(self, watcher):
         super(CrawlProcessHandler, self).add_watcher(watcher)
 
-        if self.conn and self.conn.open:
+        if self._keyframe is not None and self._keyframe_building is None:
+            for msg in self._keyframe + self._keyframe_deltas:
+                watcher.append_message(msg, False)
+            watcher.flush_messages()
+        elif self.conn and self.conn.open:
             self.conn.send_message('{"msg":"spectator_joined"}')
 
+    def _record_for_keyframe(self, msg): # type: (str) -> None
+        if self._keyframe_building is not None:
+            self._keyframe_building.append(msg)
+        elif self._keyframe is not None:
+            self._keyframe_deltas.append(msg)
+            self._keyframe_delta_bytes += len(msg)
+            if self._keyframe_delta_bytes > max_keyframe_delta_bytes:
+                self._keyframe = None
+                self._keyframe_deltas = []
+                self._keyframe_delta_bytes = 0
+
     def handle_input(self, msg): # type: (str) -> None
         obj = json_decode(msg)
 
@@ -978,6 +1014,26 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
                         self.send_to_all("dump", url = url)
                     else:
                         self.exit_dump_url = url
+            elif msgobj["msg"] == "keyframe":
+                # The game is sending (or has sent) everything, as it
+                # does for new spectators.
+                if msgobj["state"] == "begin":
+                    self._keyframe_building = []
+                elif self._keyframe_building is not None:
+                    self._keyframe = self._keyframe_building
+                    self._keyframe_building = None
+                    self._keyframe_deltas = []
+                    self._keyframe_delta_bytes = 0
+            elif msgobj["msg"] == "socket_stats":
+                # Sent once a minute at most, when the game's receivers
+                # (this server and any watching servers) fell behind.
+                self.logger.info("Game socket backlog: max %s in %d "
+                                 "datagrams, blocked %dms (max %dms), "
+                                 "%d messages dropped, %d resyncs.",
+                                 humanise_bytes(msgobj["max_backlog_bytes"]),
+                                 msgobj["max_backlog_datagrams"],
+                                 msgobj["blocked_ms"], msgobj["max_blocked_ms"],
+                                 msgobj["dropped_messages"], msgobj["resyncs"])
             elif msgobj["msg"] == "exit_reason":
                 self.exit_reason = msgobj["type"]
                 if "message" in msgobj:
@@ -997,6 +1053,7 @@ class CrawlProcessHandler(CrawlProcessHandlerBase):
                 # want that to reset idle time.
                 self.note_activity()
 
+            self._record_for_keyframe(msg)
             self.write_to_all(msg, not self.queue_messages)
 
 